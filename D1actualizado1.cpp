@@ -23,26 +23,87 @@
 #include <cctype>    // Sirve para usar la funcion toupper y tolower
 #include <limits>    // Sirve para usar la funcion numeric_limits para limpiar cin
 #include <tuple>     // Para usar tuplas
+#include <deque>     // Cola doble, usada en las filas de cada nivel de prioridad
+#include <mutex>     // Exclusion mutua entre cajas que trabajan en paralelo
+#include <condition_variable> // Espera del hilo de puntos de control entre una foto y otra
+#include <random>    // random_device para la semilla cuando no se da una
+#include <fstream>   // Lectura de la tabla de precios en CSV
+#include <atomic>    // Contadores y anillo de llegadas sin bloqueo
+#include <memory>    // unique_ptr para las celdas del anillo de llegadas
+#include <cstdint>   // Enteros de tamaño fijo (identificadores de producto)
+#include <string_view> // Nombres de producto sin copiar al buscarlos en el catalogo
+#include <unordered_map> // Indice nombre -> identificador del catalogo
+#include <shared_mutex>  // Varias lecturas simultaneas del catalogo
+#include <cstdio>    // FILE* para escribir el diario de facturas en bloques grandes
+#include <cstring>   // memcpy para leer registros binarios sin problemas de alineacion
+#include <algorithm> // sort para el resumen de productos mas vendidos
+#include <iterator>  // istreambuf_iterator para leer archivos completos
+#include <charconv>  // to_chars y from_chars: enteros a texto y de vuelta sin reservar memoria
+#include <type_traits> // Para elegir como se imprime cada tipo en las salidas
+#include <cmath>     // pow y log para las distribuciones de la carga sintetica
+#include <memory_resource>  // Arenas de memoria (pmr) para carritos, clientes y facturas de una corrida
 
 #ifdef _WIN32
   #include <windows.h> // si se corre en windows, sirve para manipular la consola del sistema
+#else
+  #include <pthread.h>  // pthread_setaffinity_np para fijar cada hilo de tiendas a un nucleo (--afinidad, Linux)
 #endif
 
+#include "D1comun.h"         // Colores, salidas, catalogo, carritos, clientes, facturas y arenas de memoria
+#include "D1diario.h"        // Diario de facturas en disco (--diario, --analizar)
+#include "D1puntocontrol.h"  // Formato de los puntos de control (--punto-control, --restaurar)
+#include "D1traza.h"         // Trazas de llegadas (--traza)
+#include "D1importacion.h"   // Importacion de clientes desde CSV o JSON (--importar)
+
 using namespace std;
 
 /**
- * @brief Declarar los colores que apareceran en la consola
+ * @brief Opciones de ejecucion que se leen desde la linea de comandos
+ * 
+ */
+struct OpcionesEjecucion {
+    bool headless = false;        // modo por lotes: sin pantallas, pausas ni preguntas al usuario
+    size_t clientes = 100000;     // cantidad de clientes que se simulan en modo headless
+    int cajas = 1;                // cajas registradoras (hilos) que atienden la fila
+    int terminales = 0;           // terminales de entrada (hilos) que hacen llegar clientes mientras se atiende; 0 = llenar la fila antes
+    string rutaPrecios;           // tabla de precios en CSV (nombre,precio); vacio = todos los precios aleatorios
+    uint64_t semilla = 0;         // semilla de los precios aleatorios; 0 = tomada del sistema (corridas no repetibles)
+    string rutaDiario;            // diario binario donde se escriben las facturas; vacio = se guardan en memoria
+    string rutaAnalisis;          // diario que se analiza fuera de linea (no se simula nada)
+    string contrapresion = "esperar";     // que hace una caja si el anillo del escritor esta lleno: esperar, descartar o sincrono
+    size_t capacidadEscritor = 4096;      // facturas que caben en el anillo de cada caja
+    string rutaTraza;             // traza de llegadas a reproducir en lugar de los clientes de prueba
+    bool generar = false;         // usar clientes sinteticos (GeneradorCarga) en lugar de los de prueba
+    string perfilCarga;           // distribuciones de la carga sintetica, "clave=valor,..."
+    string rutaGenerarTraza;      // escribe la carga sintetica como traza y termina
+    string rutaLatencias;         // CSV con los histogramas de espera y estancia al terminar la atencion
+    bool simular = false;         // simulacion por eventos con reloj virtual en lugar de atender en tiempo real
+    double tiempoBase = 15;       // segundos de atencion por cliente en la simulacion (saludo, pago, empaque)
+    double tiempoProducto = 2;    // segundos por producto escaneado en la simulacion
+    double envejecimiento = 0;    // segundos de espera que valen un nivel de prioridad; 0 = prioridad estricta
+    size_t tiendas = 1;           // tiendas simuladas a la vez en modo headless, cada una con su fila, cajas y facturas
+    int hilos = 0;                // hilos (shards) que reparten las tiendas; 0 = uno por nucleo
+    bool afinidad = false;        // fijar cada hilo de tiendas a un nucleo
+    string rutaPuntoControl;      // punto de control de la fila y las facturas que se guarda mientras se atiende
+    double intervaloPuntoControl = 1;     // segundos entre un punto de control y el siguiente
+    string rutaRestaurar;         // punto de control del que se retoma la corrida
+    string rutaImportar;          // clientes en CSV o JSON que entran juntos a la fila en lugar de los de prueba
+    string arena;                 // memoria de la corrida headless: ninguna, monotona o pool; vacio = pool
+    string salida;                // salida de la atencion: terminal, buffer o nula; vacio = terminal (interactivo) o buffer (headless)
+    bool ayuda = false;           // mostrar la forma de uso y salir
+};
+
+OpcionesEjecucion opciones;       // opciones globales del programa
+
+/**
+ * @brief Pausa de presentacion. En modo headless no hace nada para que la simulacion corra a la velocidad de la CPU
  * 
+ * @param ms Tiempo en milisegundos
  */
-const string ANS_RESET   = "\033[0m";
-const string ANS_BOLD    = "\033[1m";
-const string ANS_RED     = "\033[31m";
-const string ANS_GREEN   = "\033[32m";
-const string ANS_YELLOW  = "\033[33m";
-const string ANS_BLUE    = "\033[34m";
-const string ANS_MAGENTA = "\033[35m";
-const string ANS_CYAN    = "\033[36m";
-const string ANS_WHITE   = "\033[37m"; // codigos ansi para color y formato
+void pausa(int ms) {
+    if (opciones.headless || ms <= 0) return;
+    this_thread::sleep_for(chrono::milliseconds(ms));
+}
 
 /**
  * @brief Efecto de impresion lenta
@@ -53,7 +114,7 @@ const string ANS_WHITE   = "\033[37m"; // codigos ansi para color y formato
 void slowPrint(const string &s, int ms = 3) {   // funcion que genera una escritura mas lenta
     for (char c : s) {        //Para cada variable "char" en c (que es la misma cadena de texto s)
         cout << c << flush;     //Imprimir el caracter
-        if (ms > 0) this_thread::sleep_for(chrono::milliseconds(ms));       //Hacer que cada caracter se imprima un periodo de ms milisegundos (en este caso son 3)
+        pausa(ms);       //Hacer que cada caracter se imprima un periodo de ms milisegundos (en este caso son 3)
     }
 }
 
@@ -86,6 +147,7 @@ void clearScreen() {
  * 
  */
 void waitForEnter() {
+    if (opciones.headless) return;      // en modo headless nunca se espera al usuario
     cout << ANS_BOLD << ANS_CYAN << "\nPresiona Enter para continuar..." << ANS_RESET;
     cin.ignore(numeric_limits<streamsize>::max(), '\n');      //Ignora cualquier enter anterior al mensaje limpiando el buffer
 
@@ -96,494 +158,3219 @@ void waitForEnter() {
 
 
 /**
- * @brief CLASE CARRITO DE COMPRAS (PILA)
+ * @brief Cola global para almacenar facturas en orden cronológico
+ * 
+ */
+deque<Factura> colaFacturas;      // deque: ademas de sacar por el frente, el punto de control la recorre por posicion
+mutex mutexFacturas;        // protege colaFacturas cuando hay varias cajas atendiendo
+
+/**
+ * @brief Estado propio de una tienda cuando se simulan varias a la vez (--tiendas). Cada tienda corre en un hilo y sus
+ * cajas dejan aqui las facturas en lugar de la cola global, asi dos tiendas nunca modifican la misma memoria
+ * 
+ */
+struct Tienda {
+    uint64_t numero = 0;        // tambien separa los precios aleatorios de cada tienda (la tienda 0 cobra como una sola)
+    mutex m;                    // solo lo usan las cajas de esta tienda
+    queue<Factura> facturas;
+};
+
+thread_local Tienda* tiendaDelHilo = nullptr;       // tienda que atiende este hilo; nullptr = una sola tienda (cola global)
+
+DiarioFacturas diarioFacturas;      // se abre con --diario; si esta cerrado las facturas van a colaFacturas
+
+/**
+ * @brief Anillo acotado de un solo productor y un solo consumidor. Solo necesita dos contadores atomicos
  * 
+ * @tparam T Tipo de dato que se guarda (se mueve al meter y al sacar)
  */
-class CarritoDeCompras {
+template <class T>
+class AnilloSpsc {
 private:
-    stack<string> pila; // atributo de pila para almacenar productos
-    string nombreCliente; // atributo para identificar de quién es el carrito
+    vector<T> celdas;
+    size_t mascara;         // capacidad - 1 (la capacidad es potencia de 2)
+    alignas(64) atomic<size_t> posLectura{0};       // la mueve solo el consumidor
+    alignas(64) atomic<size_t> posEscritura{0};     // la mueve solo el productor
 
 public:
-    CarritoDeCompras(const string& nombre = "") : nombreCliente(nombre) {} //Constructor para un carrito con o sin nombre
-    
     /**
-     * @brief Meter elementos al carro de compras
+     * @brief Crea el anillo con todas sus celdas
      * 
-     * @param producto Texto que respresenta el producto metido al carrito
+     * @param capacidad Elementos que caben como minimo (se redondea a potencia de 2)
+     * @param args Argumentos con los que se construye cada celda
      */
-    void push(const string& producto) {       // agregar producto al carrito por el frente
-        pila.push(producto);      // comando que inserta un producto en la parte superior de la pila
-        cout << "Agregado al carro de " << nombreCliente << ": " << producto << "\n";
+    template <class... Args>
+    explicit AnilloSpsc(size_t capacidad, const Args&... args) {
+        size_t cap = 2;
+        while (cap < capacidad) cap <<= 1;
+        celdas.reserve(cap);
+        for (size_t i = 0; i < cap; ++i) celdas.emplace_back(args...);
+        mascara = cap - 1;
+    }
+
+    bool intentarMeter(T& dato) {       // false si esta lleno
+        size_t pos = posEscritura.load(memory_order_relaxed);
+        if (pos - posLectura.load(memory_order_acquire) > mascara) return false;
+        celdas[pos & mascara] = move(dato);
+        posEscritura.store(pos + 1, memory_order_release);
+        return true;
+    }
+
+    bool intentarSacar(T& dato) {       // false si esta vacio
+        size_t pos = posLectura.load(memory_order_relaxed);
+        if (pos == posEscritura.load(memory_order_acquire)) return false;
+        dato = move(celdas[pos & mascara]);
+        posLectura.store(pos + 1, memory_order_release);
+        return true;
     }
+};
+
+/**
+ * @brief Escritor de facturas en segundo plano. Cada caja (hilo) tiene su propio anillo SPSC hacia el hilo escritor, que
+ * los vacia en el diario; el diario agrupa los registros y los escribe en bloques de 1 MiB. Asi ninguna caja espera al disco
+ * 
+ */
+class EscritorAsincrono {
+public:
+    enum class Contrapresion { Esperar, Descartar, Sincrono };      // que hacer si el anillo de una caja esta lleno
+
+private:
+    static const size_t MAX_CANALES = 256;      // hilos distintos que pueden entregar facturas
+    DiarioFacturas* diario = nullptr;
+    Contrapresion politica = Contrapresion::Esperar;
+    size_t capacidad = 4096;
+    unique_ptr<AnilloSpsc<Factura>> canales[MAX_CANALES];
+    atomic<size_t> cantidadCanales{0};
+    mutex mutexCanales;         // solo se usa cuando un hilo nuevo pide su canal
+    thread hilo;
+    atomic<bool> activo{false};
+    atomic<bool> detenido{false};
+    atomic<size_t> descartadas{0};      // facturas perdidas con la politica Descartar
+    atomic<size_t> sincronas{0};        // facturas escritas por la caja con la politica Sincrono
 
     /**
-     * @brief Eliminar el ultimo elemento insertado al carro de compras
+     * @brief Canal del hilo actual. La primera vez que un hilo entrega una factura se le asigna uno
      * 
+     * @return AnilloSpsc<Factura>* Canal, o nullptr si ya no hay canales libres
      */
-    void pop() {
-        if (!pila.empty()) {      // verificacion de que no este vacia
-            cout << "Sacando del carro de " << nombreCliente << ": " << pila.top() << "\n";       // Obtiene la referencia del producto sin eliminarlo
-            pila.pop();       // elimina el producto de la pila
-        } else {      // verificacion si el carro esta vacio
-            cout << "El carro de " << nombreCliente << " está vacío.\n";
-        }
+    AnilloSpsc<Factura>* canalDelHilo() {
+        thread_local const EscritorAsincrono* propietario = nullptr;
+        thread_local AnilloSpsc<Factura>* canal = nullptr;
+        if (propietario == this) return canal;
+        lock_guard<mutex> lock(mutexCanales);
+        size_t n = cantidadCanales.load(memory_order_relaxed);
+        if (n == MAX_CANALES) return nullptr;
+        // el canal vive tanto como el escritor global, mas que la arena de la corrida que lo pidio: sus celdas reservan
+        // siempre del heap aunque la caja le entregue facturas reservadas de la arena (al meterlas se copian)
+        canales[n].reset(new AnilloSpsc<Factura>(capacidad, pmr::new_delete_resource()));
+        canal = canales[n].get();
+        propietario = this;
+        cantidadCanales.store(n + 1, memory_order_release);     // el escritor ve el canal ya construido
+        return canal;
     }
 
     /**
-     * @brief Atributo que devuelve true si la pila esta vacia
+     * @brief Pasa al diario todo lo que hay en los anillos
      * 
-     * @return true Si esta vacio
-     * @return false Si tiene algun elemento
+     * @return size_t Facturas escritas
      */
-    bool empty() const {
-        return pila.empty();
+    size_t drenar() {
+        size_t escritas = 0;
+        size_t n = cantidadCanales.load(memory_order_acquire);
+        Factura f(pmr::new_delete_resource());      // mismo recurso que las celdas: sacar solo mueve punteros
+        for (size_t i = 0; i < n; ++i) {
+            while (canales[i]->intentarSacar(f)) {
+                diario->agregar(f);
+                ++escritas;
+            }
+        }
+        return escritas;
     }
 
-    size_t size() const {       // Devuelve la cantidad de elementos de la pila
-        return pila.size();
+    void trabajar() {
+        while (true) {
+            bool terminar = detenido.load(memory_order_acquire);        // se lee antes de drenar para no perder las ultimas facturas
+            if (drenar() == 0) {
+                if (terminar) break;
+                this_thread::sleep_for(chrono::microseconds(200));      // nada pendiente: se cede la CPU a las cajas
+            }
+        }
     }
 
-    stack<string> getProductos() const {      // Devuelve una copia del stack sin alterar el original
-        return pila;
-    }
+public:
+    ~EscritorAsincrono() { detener(); }
 
     /**
-     * @brief Metodo para imprimir productos sin editar la pila original
+     * @brief Arranca el hilo escritor
      * 
+     * @param d Diario ya abierto
+     * @param p Politica cuando un anillo se llena
+     * @param cap Facturas que caben en el anillo de cada caja
      */
-    void mostrarProductos() {
-        cout << "Productos en el carrito de " << nombreCliente << ": ";
-        if (pila.empty()) {  // verificar que la pila no este vacia
-            cout << "(vacío)";
-        } else {
-        vector<string> temporal; // Vector temporal para guardar los productos
-
-        while (!pila.empty()) {   // Extrae los productos de la pila y los guarda temporalmente
-            temporal.push_back(pila.top());   // Agrega el producto al vector temporal
-            pila.pop();   // elimina el producto de la pila
-        }
+    void iniciar(DiarioFacturas& d, Contrapresion p, size_t cap) {
+        diario = &d;
+        politica = p;
+        capacidad = max<size_t>(cap, 2);
+        detenido.store(false);
+        hilo = thread(&EscritorAsincrono::trabajar, this);
+        activo.store(true, memory_order_release);
+    }
 
-        for (int i = temporal.size() - 1; i >= 0; --i)        // Mostrar sin perder orden original
-            cout << temporal[i] << (i ? ", " : "");
+    bool enMarcha() const { return activo.load(memory_order_acquire); }
 
-        for (string& p : temporal)  // Restaurar pila original
-            pila.push(p);
-    }
-    cout << "\n";
+    /**
+     * @brief Entrega una factura al escritor sin esperar al disco (salvo que se aplique la contrapresion)
+     * 
+     * @param f Factura terminada
+     */
+    void enviar(Factura&& f) {
+        AnilloSpsc<Factura>* canal = canalDelHilo();
+        if (canal && canal->intentarMeter(f)) return;
+
+        if (canal && politica == Contrapresion::Esperar) {      // se espera a que el escritor libere espacio
+            while (!canal->intentarMeter(f)) this_thread::yield();
+        } else if (canal && politica == Contrapresion::Descartar) {
+            descartadas.fetch_add(1, memory_order_relaxed);
+        } else {        // Sincrono (o sin canal): la caja escribe la factura ella misma
+            diario->agregar(f);
+            sincronas.fetch_add(1, memory_order_relaxed);
+        }
     }
 
     /**
-     * @brief Atributo que devuelve el nombre del cliente
+     * @brief Espera a que se escriban todas las facturas pendientes y termina el hilo escritor
      * 
-     * @return string de nombre
      */
-    string getNombreCliente() const {     
-        return nombreCliente;
+    void detener() {
+        if (!activo.exchange(false)) return;
+        detenido.store(true, memory_order_release);
+        hilo.join();
     }
+
+    size_t facturasDescartadas() const { return descartadas.load(); }
+    size_t facturasSincronas() const { return sincronas.load(); }
 };
 
+EscritorAsincrono escritorFacturas;     // hilo que escribe el diario cuando se usa --diario
 
 /**
- * @brief ESTRUCTURA CLIENTE
+ * @brief Guarda una factura: en la tienda del hilo si se simulan varias, en el escritor del diario si esta en marcha, o en
+ * la cola global. Se puede llamar desde varias cajas a la vez
  * 
+ * @param f Factura terminada
  */
-struct Cliente {            // estructura que representa el cliente con el carro
-    string nombre;          // nombre del cliente
-    CarritoDeCompras carrito; // carrito de compras del cliente
-    bool discapacidad;      // si el cliente tiene discapacidad
-    bool adultoMayor;       // si el cliente es adulto mayor
-    bool embarazada;        // si el cliente es embarazada
-    int ordenLlegada;       // orden en el que llegó el cliente
-
-    /**
-     * @brief Construct a new Cliente object
-     * 
-     * @param n Nombre
-     * @param c Carro de compras
-     * @param dis Discapacidad
-     * @param ad Adulto mayor
-     * @param emb Embarazada
-     * @param orden Orden de llegada
-     */
-    Cliente(string n, const CarritoDeCompras& c,
-            bool dis, bool ad, bool emb, int orden)       // constructor para inicializar los valores
-        : nombre(n), carrito(c),
-          discapacidad(dis), adultoMayor(ad),
-          embarazada(emb), ordenLlegada(orden) {}
-};
+void registrarFactura(Factura&& f) {
+    if (tiendaDelHilo != nullptr) {
+        lock_guard<mutex> lock(tiendaDelHilo->m);
+        tiendaDelHilo->facturas.push(move(f));
+        return;
+    }
+    if (escritorFacturas.enMarcha()) {
+        escritorFacturas.enviar(move(f));       // la factura no queda en memoria y la caja no espera al disco
+        return;
+    }
+    if (diarioFacturas.abierto()) {
+        diarioFacturas.agregar(f);
+        return;
+    }
+    lock_guard<mutex> lock(mutexFacturas);
+    colaFacturas.push_back(move(f));
+}
 
 /**
- * @brief Estructura de Factura
+ * @brief Termina la facturacion de la corrida: espera al escritor, escribe lo pendiente y cierra el diario. Se llama antes
+ * de leer el diario y antes de la pantalla final
  * 
  */
-struct Factura {
-    string nombreCliente;
-    vector<pair<string, int>> productos;      //Atributo de tipo vector de la factura que almacena 2 valores juntos siendo el producto y precio
-    int total;
-    string fechaHora;
-
-    Factura(string nombre, const vector<pair<string,int>>& prods, int tot, const string& fecha)     //Constructor para inicializar los valores
-        : nombreCliente(nombre), productos(prods), total(tot), fechaHora(fecha) {}
-};
+void terminarFacturacion() {
+    escritorFacturas.detener();
+    bool abierto = diarioFacturas.abierto();        // se llama mas de una vez: el error se muestra solo al cerrar
+    diarioFacturas.cerrar();
+    if (abierto && !diarioFacturas.getErrorEscritura().empty())
+        cerr << ANS_RED << diarioFacturas.getErrorEscritura() << ANS_RESET << "\n";
+    if (escritorFacturas.facturasDescartadas() > 0)
+        cerr << ANS_RED << "Se descartaron " << escritorFacturas.facturasDescartadas()
+             << " facturas porque el escritor no alcanzó a guardarlas" << ANS_RESET << "\n";
+}
 
 /**
- * @brief Cola global para almacenar facturas en orden cronológico
+ * @brief Generador pseudoaleatorio xoshiro256** (rapido, 32 bytes de estado). Cada hilo tiene el suyo, asi las cajas no
+ * comparten estado como pasaba con rand()
  * 
  */
-queue<Factura> colaFacturas;
+class GeneradorXoshiro {
+private:
+    uint64_t estado[4];
 
+    static uint64_t rotar(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
 
-/**
- * @brief Estructura comparativa que representa la prioridad en la atencion, devuelve 1 si el cliente a tiene menor prioridad que el cliente b. Utiliza sobrecarga de operadores
- * 
- */
-struct ComparadorPrioridad {   
-    bool operator()(const Cliente& a, const Cliente& b) const {       //Sobrecarga de operador que permite usar la estructura como una funcion agregando dos clientes y comprobando si la prioridad a es menor que b, o viceversa
-        auto prioridad = [](const Cliente& c) {     //Funcion lambda que define la prioridad de cada cliente
-            if (c.discapacidad || c.adultoMayor || c.embarazada) return 3;      // si tiene atencion especial
-            if (c.carrito.size() < 5) return 2;      // si tiene un carrito pequeño
-            return 1;       // si no tiene atencion especial ni carrito pequeño
-        };
+public:
+    explicit GeneradorXoshiro(uint64_t semilla = 1) { sembrar(semilla); }
 
-        int pa = prioridad(a);       // obtiene la prioridad del cliente a
-        int pb = prioridad(b);       // obtiene la prioridad del cliente b
+    /**
+     * @brief Reinicia el generador. El estado se llena con splitmix64 para que semillas parecidas den secuencias distintas
+     * 
+     * @param semilla Semilla
+     */
+    void sembrar(uint64_t semilla) {
+        for (uint64_t& e : estado) {
+            uint64_t z = (semilla += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            e = z ^ (z >> 31);
+        }
+    }
 
-        if (pa != pb) return pa < pb;     //En caso de empate, la prioridad la tiene el que halla llegado antes (tenga un orden de llegada menor)
-        return a.ordenLlegada > b.ordenLlegada;
+    uint64_t siguiente() {      // siguiente numero de 64 bits
+        uint64_t resultado = rotar(estado[1] * 5, 7) * 9;
+        uint64_t t = estado[1] << 17;
+        estado[2] ^= estado[0];
+        estado[3] ^= estado[1];
+        estado[1] ^= estado[2];
+        estado[0] ^= estado[3];
+        estado[2] ^= t;
+        estado[3] = rotar(estado[3], 45);
+        return resultado;
+    }
+
+    /**
+     * @brief Entero en [minimo, maximo] usando multiplicacion en lugar de modulo
+     * 
+     * @return int Numero en el rango
+     */
+    int entre(int minimo, int maximo) {
+        uint64_t rango = static_cast<uint64_t>(maximo - minimo) + 1;
+        return minimo + static_cast<int>(((siguiente() >> 32) * rango) >> 32);
     }
-};
 
+    double uniforme() {     // real en [0, 1)
+        return (siguiente() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
 
 /**
- * @brief PROCESAR EL CARRITO (ASIGNAR PRECIOS Y GUARDAR FACTURA)
+ * @brief Motor de precios: una tabla indexada por IdProducto (busqueda O(1)) que se carga desde un CSV. Los productos que
+ * no estan en la tabla reciben un precio aleatorio entre 1000 y 20000 que depende solo de la semilla y del cliente, por lo
+ * que una corrida con la misma semilla da los mismos precios sin importar cuantas cajas haya
  * 
- * @param nombreCliente Nombre del cliente al que se le esta cobrando
- * @param carrito Carro que tiene los objetos
- * @return int Devuelve el precio total
  */
-int procesarCarrito(const string& nombreCliente, stack<string> carrito) {
-    srand(static_cast<unsigned>(time(0)) + rand());       // Genera precios aleatorios para que ningun producto tenga el mismo precio
-    int total = 0;      // sirve para obtener el precio total
-    vector<pair<string, int>> productosFactura;     //Declaracion de vectores que guarda pares conformados por un string y un int (el nombre y precio del producto)
+class MotorPrecios {
+private:
+    vector<int> precioPorId;        // 0 = producto sin precio fijo
+    uint64_t semilla = 0;
 
-    cout << ANS_YELLOW << "Procesando carrito...\n" << ANS_RESET;
-    while (!carrito.empty()) {      // mientras que el carrito no este vacio
-        string producto = carrito.top();      // guarda el nombre del producto superior
-        carrito.pop();      // elimina el producto
+public:
+    void fijarSemilla(uint64_t s) { semilla = s; }
+    uint64_t getSemilla() const { return semilla; }
 
+    /**
+     * @brief Fija el precio de un producto
+     * 
+     * @param id Producto del catalogo
+     * @param precio Precio en pesos
+     */
+    void fijarPrecio(IdProducto id, int precio) {
+        if (id >= precioPorId.size()) precioPorId.resize(id + 1, 0);
+        precioPorId[id] = precio;
+    }
 
-        int precio = 1000 + rand() % 19001;       // precio aleatorio entre 1000 y 20000
-        cout << " - " << producto << ": $" << precio << endl;
-        total += precio;      //Se va acumulando el precio total en la variable total
+    /**
+     * @brief Carga precios de un archivo CSV con lineas "nombre,precio". Se ignoran lineas vacias y un encabezado
+     * 
+     * @param ruta Archivo CSV
+     * @param error Mensaje si algo falla
+     * @return true Si se cargo el archivo
+     */
+    bool cargarCsv(const string& ruta, string& error) {
+        ifstream archivo(ruta);
+        if (!archivo) {
+            error = "No se pudo abrir " + ruta;
+            return false;
+        }
+        string linea;
+        int numero = 0;
+        while (getline(archivo, linea)) {
+            ++numero;
+            if (!linea.empty() && linea.back() == '\r') linea.pop_back();       // archivos guardados en Windows
+            if (linea.empty()) continue;
+            size_t coma = linea.rfind(',');
+            if (coma == string::npos || coma == 0) {
+                error = ruta + ":" + to_string(numero) + ": se esperaba nombre,precio";
+                return false;
+            }
+            int precio = 0;
+            const char* finCampo = linea.data() + linea.size();
+            auto leido = from_chars(linea.data() + coma + 1, finCampo, precio);       // el campo completo, sin texto de mas
+            if (leido.ec != errc() || leido.ptr != finCampo) {
+                if (numero == 1) continue;      // encabezado
+                error = ruta + ":" + to_string(numero) + ": precio inválido";
+                return false;
+            }
+            if (precio <= 0) {
+                error = ruta + ":" + to_string(numero) + ": el precio debe ser positivo";
+                return false;
+            }
+            fijarPrecio(catalogo().registrar(string_view(linea).substr(0, coma)), precio);
+        }
+        return true;
+    }
 
-        productosFactura.push_back({producto, precio});     //Se guarda en el vector las el nombre y precio del producto
+    /**
+     * @brief Prepara el generador del hilo para cobrar a un cliente. Asi los precios aleatorios de un cliente no dependen
+     * de que caja lo atienda
+     * 
+     * @param gen Generador del hilo
+     * @param ordenLlegada Orden de llegada del cliente
+     */
+    void prepararCliente(GeneradorXoshiro& gen, int ordenLlegada) const {
+        uint64_t tienda = tiendaDelHilo != nullptr ? tiendaDelHilo->numero : 0;
+        gen.sembrar(semilla ^ (static_cast<uint64_t>(ordenLlegada) * 0xD1B54A32D192ED03ULL) ^ (tienda * 0x9E3779B97F4A7C15ULL));
     }
 
+    /**
+     * @brief Precio de un producto
+     * 
+     * @param id Producto
+     * @param gen Generador del hilo, para productos sin precio fijo
+     * @return int Precio en pesos
+     */
+    int precio(IdProducto id, GeneradorXoshiro& gen) const {
+        if (id < precioPorId.size() && precioPorId[id] > 0) return precioPorId[id];
+        return gen.entre(1000, 20000);       // precio aleatorio entre 1000 y 20000
+    }
+};
 
-    time_t now = time(0);
-    string fechaHora = ctime(&now);       // Obtener fecha y hora actuales
-    if (!fechaHora.empty() && fechaHora.back() == '\n') fechaHora.pop_back();       // eliminar el "\n" del final (salto de línea)
+MotorPrecios motorPrecios;      // precios del D1 (se configura en main antes de atender)
 
-    cout << ANS_GREEN << "Total a pagar: $" << total << ANS_RESET << "\n";
-    cout << "----------------------------------------\n";
-    this_thread::sleep_for(chrono::milliseconds(450));
+/**
+ * @brief Generador de precios propio de cada hilo
+ * 
+ * @return GeneradorXoshiro& Generador del hilo actual
+ */
+GeneradorXoshiro& generadorPrecios() {
+    thread_local GeneradorXoshiro generador;
+    return generador;
+}
 
+/**
+ * @brief Politica de prioridad de una tienda, fijada en compilacion: el limite de la caja rapida y el nivel (1 a 3) que
+ * recibe cada clase de cliente. Las colas la reciben como parametro de plantilla, asi cambiar de regla no agrega ni un
+ * if por comparacion: el compilador ve las constantes y deja el calculo de la clave en linea
+ * 
+ * @tparam LIMITE_EXPRESS Un carrito con menos productos que esto va por la caja rapida
+ * @tparam NIVEL_ESPECIAL Nivel de discapacidad, adulto mayor y embarazada
+ * @tparam NIVEL_EXPRESS Nivel de un carrito pequeño
+ * @tparam NIVEL_NORMAL Nivel de los demas
+ */
+template <size_t LIMITE_EXPRESS = 5, int NIVEL_ESPECIAL = 3, int NIVEL_EXPRESS = 2, int NIVEL_NORMAL = 1>
+struct PoliticaD1 {
+    static constexpr int NIVELES = 3;       // las estadisticas por nivel (LatenciasPorNivel) tienen 3 filas
+    static constexpr size_t limiteExpress = LIMITE_EXPRESS;
+    static_assert(NIVEL_ESPECIAL >= 1 && NIVEL_ESPECIAL <= NIVELES, "nivel especial fuera de rango");
+    static_assert(NIVEL_EXPRESS >= 1 && NIVEL_EXPRESS <= NIVELES, "nivel express fuera de rango");
+    static_assert(NIVEL_NORMAL >= 1 && NIVEL_NORMAL <= NIVELES, "nivel normal fuera de rango");
+
+    static int nivel(const Cliente& c) {
+        if (c.discapacidad || c.adultoMayor || c.embarazada) return NIVEL_ESPECIAL;      // si tiene atencion especial
+        if (c.carrito.size() < LIMITE_EXPRESS) return NIVEL_EXPRESS;      // si tiene un carrito pequeño
+        return NIVEL_NORMAL;       // si no tiene atencion especial ni carrito pequeño
+    }
+};
 
-    Factura nueva(nombreCliente, productosFactura, total, fechaHora);       // Crear factura y almacenarla en la cola
-    colaFacturas.push(nueva);
+using PoliticaPorDefecto = PoliticaD1<>;        // la regla del D1: especiales, luego menos de 5 productos, luego los demas
 
-    return total;
+/**
+ * @brief Nivel de prioridad de un cliente con la politica por defecto: 3 atencion especial, 2 carrito pequeño (menos de 5
+ * productos), 1 los demas
+ * 
+ * @param c Cliente a evaluar
+ * @return int Nivel entre 1 y 3
+ */
+inline int nivelPrioridad(const Cliente& c) {
+    return PoliticaPorDefecto::nivel(c);
 }
 
+/**
+ * @brief Estructura comparativa que representa la prioridad en la atencion, devuelve 1 si el cliente a tiene menor prioridad que el cliente b. Utiliza sobrecarga de operadores
+ * 
+ * @tparam Politica Regla de prioridad de la tienda
+ */
+template <class Politica = PoliticaPorDefecto>
+struct ComparadorPrioridad {   
+    bool operator()(const Cliente& a, const Cliente& b) const {       //Sobrecarga de operador que permite usar la estructura como una funcion agregando dos clientes y comprobando si la prioridad a es menor que b, o viceversa
+        int pa = Politica::nivel(a);       // obtiene la prioridad del cliente a
+        int pb = Politica::nivel(b);       // obtiene la prioridad del cliente b
 
+        if (pa != pb) return pa < pb;     //En caso de empate, la prioridad la tiene el que halla llegado antes (tenga un orden de llegada menor)
+        return a.ordenLlegada > b.ordenLlegada;
+    }
+};
 
+/**
+ * @brief Manejador estable de un cliente en la fila (ranura y generacion): sigue siendo valido aunque el cliente cambie de
+ * posicion en el heap, y deja de serlo cuando el cliente sale de la fila
+ * 
+ */
+using ManejadorCliente = uint64_t;
+const ManejadorCliente MANEJADOR_INVALIDO = ~0ULL;
 
 /**
- * @brief CLASE COLA CON PRIORIDAD (FILA DEL D1): simula la fila del supermercado pero con niveles de prioridad
+ * @brief Cola por niveles (bucket queue): una cola FIFO por cada nivel de prioridad. Como solo hay 3 niveles y dentro de cada
+ * nivel se atiende por orden de llegada, meter y sacar clientes es O(1) y da exactamente el mismo orden que ComparadorPrioridad.
+ * No da manejadores: sus clientes no pueden abandonar la fila ni cambiar de nivel mientras esperan.
+ * 
+ * Con envejecimiento se compara solo al primero de cada nivel, que es el que mas lleva esperando en su nivel, con la misma
+ * clave que HeapIndexado (nivel * nsPorNivel - llegadaNs en milisegundos, y por orden de llegada si empatan). Tampoco hay
+ * que reordenar nada cuando pasa el tiempo
  * 
+ * @tparam Politica Regla de prioridad de la tienda
  */
-class ColaPrioritariaD1 {
+template <class Politica = PoliticaPorDefecto>
+class ColaPorNiveles {
 private:
-    priority_queue<Cliente, vector<Cliente>, ComparadorPrioridad> cola;       //Define una cola con prioridad de tipo cliente, que van a ser almacenados en un vector y tienen de comparador a ComparadorPrioridad
-    int contadorLlegadas = 0;       //Contador para el orden de llegada de los clientes
+    static const int NIVELES = Politica::NIVELES;
+    static constexpr int64_t CUANTO_NS = 1000000;       // resolucion de la prioridad con envejecimiento (1 ms), como HeapIndexado
+    deque<Cliente> niveles[NIVELES];        // niveles[0] es la prioridad 1 y niveles[2] la prioridad 3
+    size_t cantidad = 0;        // clientes en todos los niveles
+    int64_t nsPorNivel = 0;     // envejecimiento: espera que vale un nivel de prioridad; 0 = prioridad estricta
+    PuntoDeControl* foto = nullptr;     // punto de control en curso
+    size_t sinCopiar[NIVELES] = {};     // por nivel: los primeros sinCopiar clientes son de T0 y aun no entran a la foto
+    bool frenteCopiado[NIVELES] = {};   // el primero del nivel ya se copio (top) y esta por salir (pop)
 
-public:
+    /**
+     * @brief Turno con envejecimiento del primero de un nivel: menor turno = se atiende antes
+     * 
+     */
+    int64_t turno(int i) const {
+        int64_t turnoNs = niveles[i].front().llegadaNs - (i + 1) * nsPorNivel;
+        return turnoNs / CUANTO_NS - (turnoNs % CUANTO_NS < 0 ? 1 : 0);       // division hacia abajo
+    }
 
     /**
-     * @brief Agrega un cliente a la cola
+     * @brief Indice del nivel cuyo primer cliente se atiende ahora
      * 
-     * @param nombre Nombre del cliente
-     * @param carrito Carro del cliente
-     * @param discapacidad Si el cliente presenta discapacidad
-     * @param adultoMayor Si el cliente es un adulto mayor
-     * @param embarazada Si el cliente esta embarazada
+     * @return int Indice en niveles (solo se llama si la cola no esta vacia)
      */
-    void agregarCliente(const string& nombre, const CarritoDeCompras& carrito,      // agrega un cliente a la cola
-                        bool discapacidad, bool adultoMayor, bool embarazada) {
-        cola.emplace(nombre, carrito, discapacidad, adultoMayor, embarazada, contadorLlegadas++);       //Agrega el cliente a la cola mediante .emplace() y aumenta el contador de llegadas
-        cout << ANS_GREEN << " " << nombre << " ha llegado al D1 con " << carrito.size() << " productos." << ANS_RESET << "\n";       //Muestra el nombre del cliente y numero de productos
+    int nivelMasAlto() const {
+        if (nsPorNivel == 0) {
+            for (int i = NIVELES - 1; i > 0; --i)
+                if (!niveles[i].empty()) return i;
+            return 0;
+        }
+        int mejor = -1;
+        int64_t mejorTurno = 0;
+        for (int i = NIVELES - 1; i >= 0; --i) {
+            if (niveles[i].empty()) continue;
+            int64_t t = turno(i);
+            if (mejor < 0 || t < mejorTurno ||
+                (t == mejorTurno && niveles[i].front().ordenLlegada < niveles[mejor].front().ordenLlegada)) {
+                mejor = i;
+                mejorTurno = t;
+            }
+        }
+        return mejor;
     }
 
+public:
     /**
-     * @brief Funcion para saber si quedan clientes en la cola
+     * @brief Mete un cliente al final de la fila de su nivel. La prioridad se calcula una sola vez. Si llegan desde
+     * varias terminales un cliente puede entrar un poco despues de otro con mayor orden de llegada; en ese caso se
+     * ubica retrocediendo desde el final para que el nivel siga ordenado (sin pasar a los de T0 de un punto de control)
      * 
-     * @return true Si no hay mas clientes
-     * @return false Si quedan clientes
+     * @param c Cliente que llega
+     * @return ManejadorCliente Siempre MANEJADOR_INVALIDO
      */
-    bool empty() const { return cola.empty(); }       //True si no hay mas clientes en la cola
+    ManejadorCliente push(Cliente c) {
+        int i = Politica::nivel(c) - 1;
+        deque<Cliente>& fila = niveles[i];
+        if (fila.empty() || fila.back().ordenLlegada < c.ordenLlegada) {
+            fila.push_back(move(c));        // caso normal: es el ultimo en llegar
+        } else {
+            auto pos = fila.end();
+            auto limite = fila.begin() + sinCopiar[i];
+            while (pos != limite && prev(pos)->ordenLlegada > c.ordenLlegada) --pos;
+            fila.insert(pos, move(c));
+        }
+        ++cantidad;
+        return MANEJADOR_INVALIDO;
+    }
 
     /**
-     * @brief Funcion que atiende los clientes y los elimina de la cola
+     * @brief Construye el cliente directamente en la fila de su nivel
      * 
      */
-    void atenderClientes() {
-        cout << "\n" << ANS_BLUE << " INICIO DE ATENCIÓN EN D1 \n\n" << ANS_RESET;
+    template <class... Args>
+    void emplace(Args&&... args) {
+        push(Cliente(forward<Args>(args)...));
+    }
+
+    const Cliente& top() const { return niveles[nivelMasAlto()].front(); }     // cliente con mayor prioridad
+    Cliente& top() {        // para sacarlo: si es parte de un punto de control en curso se copia antes
+        int i = nivelMasAlto();
+        if (sinCopiar[i] > 0 && !frenteCopiado[i]) {
+            foto->agregarCliente(niveles[i].front());
+            frenteCopiado[i] = true;
+        }
+        return niveles[i].front();
+    }
+
+    void pop() {        // elimina el cliente con mayor prioridad (antes se mueve con top)
+        int i = nivelMasAlto();
+        if (sinCopiar[i] > 0) {
+            if (!frenteCopiado[i]) foto->agregarCliente(niveles[i].front());
+            --sinCopiar[i];
+        }
+        frenteCopiado[i] = false;
+        niveles[i].pop_front();
+        --cantidad;
+    }
 
-        while (!cola.empty()) {
-            Cliente c = cola.top();       //Obtiene el primer cliente de la cola (El de mayor prioridad)
-            cola.pop();       // Elimina el primer cliente de la cola
+    /**
+     * @brief Mete muchos clientes de una vez (por ejemplo al restaurar un punto de control). Se ordenan por llegada
+     * para que cada uno entre al final de su nivel
+     * 
+     * @param lista Clientes con su orden de llegada ya asignado
+     */
+    void cargar(vector<Cliente>&& lista) {
+        auto porLlegada = [](const Cliente& a, const Cliente& b) { return a.ordenLlegada < b.ordenLlegada; };
+        if (!is_sorted(lista.begin(), lista.end(), porLlegada)) sort(lista.begin(), lista.end(), porLlegada);
+        for (Cliente& c : lista) push(move(c));
+    }
 
-            cout << ANS_MAGENTA << "Atendiendo a " << c.nombre << " (" << c.carrito.size() << " productos)";
-            if (c.discapacidad) cout << " Discapacitado";
-            else if (c.adultoMayor) cout << " Adulto Mayor";
-            else if (c.embarazada) cout << " Embarazada"; // mostrar las razones de la prioridad
-            cout << ANS_RESET << "\n";
-            c.carrito.mostrarProductos(); // imprime los productos
-            int total = procesarCarrito(c.nombre, c.carrito.getProductos()); // Procesa el carrito
+    /**
+     * @brief Cambia la politica de prioridad. No hay que mover a nadie: cada nivel sigue en orden de llegada
+     * 
+     * @param ns Espera en nanosegundos que vale un nivel de prioridad; 0 = prioridad estricta
+     */
+    void fijarEnvejecimiento(int64_t ns) { nsPorNivel = max<int64_t>(ns, 0); }
 
-            cout << ANS_GREEN << " " << c.nombre << " pagó $" << total << ANS_RESET << "\n\n";
-            // Pausa pequeña entre clientes para que sea legible
-            this_thread::sleep_for(chrono::milliseconds(800));
+    /**
+     * @brief Marca T0 de un punto de control: no copia nada. Los clientes de T0 quedan al frente de cada nivel (los
+     * que llegan despues tienen turno mayor y van detras), asi que basta contarlos: el hilo del punto de control los
+     * copia desde atras con copiarFoto y las cajas copian el primero antes de sacarlo
+     * 
+     * @param p Punto de control que se esta tomando
+     */
+    void iniciarFoto(PuntoDeControl& p) {
+        foto = &p;
+        for (int i = 0; i < NIVELES; ++i) {
+            sinCopiar[i] = niveles[i].size();
+            frenteCopiado[i] = false;
         }
+    }
 
-        cout << ANS_YELLOW << " Todos los clientes han sido atendidos correctamente.\n" << ANS_RESET;
+    /**
+     * @brief Copia un trozo de los clientes de T0 que siguen en la fila. Se llama con la fila bloqueada, un trozo a la vez
+     * 
+     * @param cuantos Clientes que se copian como maximo
+     * @return true Si ya se copiaron todos y el punto de control termino con la fila
+     */
+    bool copiarFoto(size_t cuantos) {
+        if (foto == nullptr) return true;
+        for (int i = 0; i < NIVELES && cuantos > 0; ++i) {
+            size_t primero = frenteCopiado[i] ? 1 : 0;
+            for (; sinCopiar[i] > primero && cuantos > 0; --cuantos) foto->agregarCliente(niveles[i][--sinCopiar[i]]);
+            if (sinCopiar[i] == primero) sinCopiar[i] = 0;      // si queda el primero, ya lo copio top
+        }
+        for (int i = 0; i < NIVELES; ++i)
+            if (sinCopiar[i] > 0) return false;
+        foto = nullptr;
+        return true;
     }
+
+    bool empty() const { return cantidad == 0; }
+    size_t size() const { return cantidad; }
 };
 
 /**
- * @brief VISUALES ASCII: Pantallas
+ * @brief Tabla de clientes por ranura: la parte fria de la fila. Nombre, carrito y banderas se guardan aqui y solo se
+ * leen al atender o al editar un cliente; el heap trabaja con el indice de la ranura
  * 
- * @param title 
  */
-void printHeader(const string &title) {
-    const int WIDTH = 90;
-    cout << ANS_BOLD << ANS_BLUE;
-    cout << string(WIDTH, '=') << "\n";
-    int pad = (WIDTH - static_cast<int>(title.size())) / 2;
-    if (pad < 0) pad = 0;
-    cout << string(pad, ' ') << title << "\n";
-    cout << string(WIDTH, '=') << ANS_RESET << "\n";
-}
+class TablaClientes {
+private:
+    vector<Cliente> clientes;           // frio: se toca una vez al entrar y otra al salir
+    vector<uint32_t> generaciones;      // cambia cada vez que la ranura se libera: invalida los manejadores viejos
+    vector<uint32_t> libres;
 
-/**
- * @brief Escena 1: Pasillo con estantes (ASCII puro)
- * 
- */
-void pantallaInicio() {
-    clearScreen();
-    printHeader(" BIENVENIDO AL D1 - PASILLO PRINCIPAL ");
+public:
+    /**
+     * @brief Guarda un cliente en una ranura libre (o en una nueva)
+     * 
+     * @param c Cliente
+     * @return uint32_t Ranura
+     */
+    uint32_t ocupar(Cliente c) {
+        if (!libres.empty()) {
+            uint32_t r = libres.back();
+            libres.pop_back();
+            clientes[r] = move(c);
+            return r;
+        }
+        clientes.push_back(move(c));
+        generaciones.push_back(0);
+        return static_cast<uint32_t>(clientes.size() - 1);
+    }
 
-    // Representacion de los articulos a comprar (Luego sera implementado con diccionarios)
-    cout << "\n";
-    cout << ANS_YELLOW << "[ESTANTE SUPERIOR] " << ANS_RESET;
-    cout << ANS_RED << "[Tomates] " << ANS_GREEN << "[Lechuga] " << ANS_RED << "[Manzanas] ";
-    cout << ANS_MAGENTA << "[Galletas] " << ANS_CYAN << "[Bebidas] " << ANS_RESET << "\n\n";
+    void liberar(uint32_t r) {      // el cliente ya se movio o se descarta
+        ++generaciones[r];
+        libres.push_back(r);
+    }
 
-    cout << ANS_YELLOW << "[ESTANTE MEDIO]    " << ANS_RESET;
-    cout << ANS_GREEN << "[Arroz] " << ANS_YELLOW << "[Aceite] " << ANS_RED << "[Carne] ";
-    cout << ANS_MAGENTA << "[Galletas] " << ANS_CYAN << "[Agua] " << ANS_RESET << "\n\n";
+    ManejadorCliente manejador(uint32_t r) const { return (static_cast<uint64_t>(generaciones[r]) << 32) | r; }
 
-    cout << ANS_YELLOW << "[ESTANTE INFERIOR] " << ANS_RESET;
-    cout << ANS_CYAN << "[Leche] " << ANS_GREEN << "[Huevos] " << ANS_YELLOW << "[Pan] ";
-    cout << ANS_RED << "[Dulces] " << ANS_MAGENTA << "[Snacks] " << ANS_RESET << "\n\n";
+    bool vigente(ManejadorCliente h) const {        // la ranura existe y no se libero desde que se entrego el manejador
+        uint32_t r = static_cast<uint32_t>(h);
+        return r < clientes.size() && generaciones[r] == static_cast<uint32_t>(h >> 32);
+    }
 
-    // Explanatory text
-    cout << ANS_WHITE << "Modo: " << ANS_RESET;
-    cout << "Prueba rápida (clientes predefinidos) o crear tus propios clientes.\n\n";
+    void reservar(size_t n) {       // ranuras para n clientes sin mover los que ya estan
+        clientes.reserve(n);
+        generaciones.reserve(n);
+    }
 
-    cout << ANS_BOLD << "¿Deseas usar el modo de prueba (clientes predefinidos)? (S/N): " << ANS_RESET;
-    // Pregunta para empezar un modo precargado.
-}
+    void adoptar(vector<Cliente>&& lista) {     // con la tabla vacia: la lista pasa a ser las ranuras 0..n-1 sin mover a nadie
+        clientes = move(lista);
+        generaciones.assign(clientes.size(), 0);
+        libres.clear();
+    }
 
+    size_t capacidad() const { return clientes.size(); }
+    Cliente& operator[](uint32_t r) { return clientes[r]; }
+    const Cliente& operator[](uint32_t r) const { return clientes[r]; }
+};
 
 /**
- * @brief Transicion
+ * @brief Heap indexado de clientes. Los clientes viven en ranuras fijas de una TablaClientes y el heap solo mueve claves
+ * de 64 bits en un arreglo denso (con la ranura en un arreglo paralelo), asi cada cliente conserva su manejador y un
+ * reacomodo toca 16 bytes por cliente (clave, ranura y su posicion) en lugar del Cliente completo. Ademas de
+ * push/top/pop permite sacar (remove) o reordenar (update) un cliente cualquiera en O(log n), por ejemplo si abandona la
+ * fila o si su carrito cruza el limite de la caja rapida mientras espera.
  * 
+ * La clave empaqueta la prioridad en los 32 bits altos y el orden de llegada invertido en los 32 bajos, asi comparar es
+ * comparar dos enteros. Con prioridad estricta la parte alta es el nivel: el mismo orden que ComparadorPrioridad. Con
+ * envejecimiento la prioridad efectiva es nivel + espera / nsPorNivel; como el reloj es el mismo para todos, comparar eso
+ * equivale a comparar nivel * nsPorNivel - llegadaNs, que no cambia mientras el cliente espera: nunca hay que reordenar
+ * la fila porque pase el tiempo. Esa parte se guarda en milisegundos desde el primer cliente (±24 dias); dos clientes
+ * dentro del mismo milisegundo se atienden por orden de llegada
+ * 
+ * @tparam Politica Regla de prioridad de la tienda
  */
-void pantallaIntermedia() {
-    clearScreen();
-    const string text = " INICIO DE ATENCIÓN EN D1 ";
-    const int WIDTH = 90;
-    // Simulate sliding from right to center slowly
-    for (int pos = WIDTH; pos >= (WIDTH - static_cast<int>(text.size())) / 2; pos -= 2) {
-        clearScreen();
-        printHeader("");
-        // print empty lines to center vertically a bit
-        cout << "\n\n\n";
-        int leftPad = max(0, pos);
-        cout << string(leftPad, ' ');
-        cout << ANS_BOLD << ANS_YELLOW << text << ANS_RESET << "\n\n\n";
-        this_thread::sleep_for(chrono::milliseconds(120)); // lento y vistoso
+template <class Politica = PoliticaPorDefecto>
+class HeapIndexado {
+private:
+    static constexpr uint32_t FUERA = ~0u;      // posicion de una ranura libre
+    static constexpr size_t ARIDAD = 4;         // heap 4-ario: la mitad de niveles que uno binario y los hijos juntos en cache
+    static constexpr int64_t CUANTO_NS = 1000000;       // resolucion de la prioridad con envejecimiento (1 ms)
+    static constexpr int64_t CENTRO = int64_t(1) << 31;
+
+    TablaClientes tabla;                // frio
+    vector<uint32_t> posiciones;        // indice en el heap de cada ranura, FUERA si esta libre
+    vector<uint64_t> claves;            // caliente: el heap, mayor clave = se atiende antes
+    vector<uint32_t> ranuras;           // ranura de cada clave (paralelo a claves)
+    int64_t nsPorNivel = 0;         // envejecimiento: espera que vale un nivel de prioridad; 0 = prioridad estricta
+    int64_t origenNs = 0;           // llegada del primer cliente con envejecimiento: la parte alta de la clave es relativa a ella
+    bool hayOrigen = false;
+    PuntoDeControl* foto = nullptr;     // punto de control en curso: las ranuras de T0 se copian antes de tocarlas
+    vector<uint8_t> copiadas;           // por ranura de T0: 1 si ya se copio o si se ocupo despues de T0
+    size_t cursorFoto = 0;              // siguiente ranura que copia el hilo del punto de control
+
+    uint64_t clave(const Cliente& c) const {
+        uint64_t orden = 0xFFFFFFFFu - static_cast<uint32_t>(c.ordenLlegada);
+        int64_t prioridad = Politica::nivel(c);
+        if (nsPorNivel > 0) {
+            int64_t turnoNs = (c.llegadaNs - origenNs) - prioridad * nsPorNivel;      // menor turno = se atiende antes
+            int64_t turno = turnoNs / CUANTO_NS - (turnoNs % CUANTO_NS < 0 ? 1 : 0);      // division hacia abajo
+            prioridad = CENTRO - turno;
+            prioridad = min<int64_t>(max<int64_t>(prioridad, 0), 0xFFFFFFFF);
+        }
+        return (static_cast<uint64_t>(prioridad) << 32) | orden;
     }
 
-    cout << "\n";               //Pequeña pausa
-    cout << ANS_CYAN << "Presiona Enter para comenzar la atención..." << ANS_RESET;
-    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-
-    string dummy;
-    getline(cin, dummy);
-}
+    void colocar(size_t i, uint64_t k, uint32_t r) {
+        claves[i] = k;
+        ranuras[i] = r;
+        posiciones[r] = static_cast<uint32_t>(i);
+    }
+
+    void subir(size_t i) {
+        uint64_t k = claves[i];
+        uint32_t r = ranuras[i];
+        while (i > 0) {
+            size_t padre = (i - 1) / ARIDAD;
+            if (claves[padre] >= k) break;
+            colocar(i, claves[padre], ranuras[padre]);
+            i = padre;
+        }
+        colocar(i, k, r);
+    }
+
+    void bajar(size_t i) {
+        uint64_t k = claves[i];
+        uint32_t r = ranuras[i];
+        size_t n = claves.size();
+        while (true) {
+            size_t primero = ARIDAD * i + 1;
+            if (primero >= n) break;
+            size_t hijo = primero;
+            for (size_t j = primero + 1; j < min(primero + ARIDAD, n); ++j)
+                if (claves[j] > claves[hijo]) hijo = j;
+            if (claves[hijo] <= k) break;
+            colocar(i, claves[hijo], ranuras[hijo]);
+            i = hijo;
+        }
+        colocar(i, k, r);
+    }
+
+    void quitarEn(size_t i) {       // saca la entrada i del heap y libera su ranura (el cliente ya se movio)
+        uint32_t r = ranuras[i];
+        uint64_t k = claves.back();
+        uint32_t ultima = ranuras.back();
+        claves.pop_back();
+        ranuras.pop_back();
+        if (i < claves.size()) {
+            claves[i] = k;
+            ranuras[i] = ultima;
+            if (i > 0 && k > claves[(i - 1) / ARIDAD]) subir(i);
+            else bajar(i);
+        }
+        posiciones[r] = FUERA;
+        tabla.liberar(r);
+    }
+
+    bool valido(ManejadorCliente h) const {
+        return tabla.vigente(h) && posiciones[static_cast<uint32_t>(h)] != FUERA;
+    }
+
+    /**
+     * @brief Copia al escribir: si hay un punto de control en curso y el cliente de la ranura aun no se copio, se copia
+     * antes de que lo saquen o lo cambien
+     * 
+     * @param r Ranura ocupada
+     */
+    void copiarAntes(uint32_t r) {
+        if (foto != nullptr && r < copiadas.size() && !copiadas[r]) {
+            copiadas[r] = 1;
+            foto->agregarCliente(tabla[r]);
+        }
+    }
+
+    void ocupar(Cliente&& c, uint64_t k) {      // guarda el cliente en una ranura y agrega su clave al final del heap
+        uint32_t r = tabla.ocupar(move(c));
+        if (r >= posiciones.size()) posiciones.resize(tabla.capacidad(), FUERA);
+        if (r < copiadas.size()) copiadas[r] = 1;       // ranura libre en T0: su cliente no es parte de la foto
+        posiciones[r] = static_cast<uint32_t>(claves.size());
+        claves.push_back(k);
+        ranuras.push_back(r);
+    }
+
+public:
+    /**
+     * @brief Mete un cliente
+     * 
+     * @param c Cliente (con su orden de llegada ya asignado)
+     * @return ManejadorCliente Manejador para sacarlo o reordenarlo despues
+     */
+    ManejadorCliente push(Cliente c) {
+        if (nsPorNivel > 0 && !hayOrigen) {
+            origenNs = c.llegadaNs;
+            hayOrigen = true;
+        }
+        uint64_t k = clave(c);
+        ocupar(move(c), k);
+        uint32_t r = ranuras.back();
+        subir(claves.size() - 1);
+        return tabla.manejador(r);
+    }
+
+    /**
+     * @brief Mete muchos clientes de una vez (por ejemplo al restaurar un punto de control) y rearma el heap en O(n)
+     * 
+     * @param lista Clientes con su orden de llegada ya asignado
+     */
+    void cargar(vector<Cliente>&& lista) {
+        if (lista.empty()) return;
+        if (nsPorNivel > 0 && !hayOrigen) {
+            origenNs = lista.front().llegadaNs;
+            hayOrigen = true;
+        }
+        if (tabla.capacidad() == 0) {       // fila nueva (restaurar): los clientes se quedan en el vector que llega
+            size_t n = lista.size();
+            tabla.adoptar(move(lista));
+            posiciones.resize(n);
+            claves.resize(n);
+            ranuras.resize(n);
+            for (uint32_t r = 0; r < n; ++r) colocar(r, clave(tabla[r]), r);
+        } else {
+            tabla.reservar(tabla.capacidad() + lista.size());
+            claves.reserve(claves.size() + lista.size());
+            ranuras.reserve(ranuras.size() + lista.size());
+            for (Cliente& c : lista) {
+                uint64_t k = clave(c);
+                ocupar(move(c), k);
+            }
+        }
+        if (claves.size() > 1)
+            for (size_t i = (claves.size() - 2) / ARIDAD + 1; i-- > 0;) bajar(i);
+    }
+
+    const Cliente& top() const { return tabla[ranuras.front()]; }     // cliente con mayor prioridad
+    Cliente& top() {        // para sacarlo: si es parte de un punto de control en curso se copia antes
+        copiarAntes(ranuras.front());
+        return tabla[ranuras.front()];
+    }
+
+    void pop() { quitarEn(0); }     // elimina el cliente con mayor prioridad (antes se mueve con top)
+
+    /**
+     * @brief Saca de la fila a un cliente cualquiera
+     * 
+     * @param h Manejador del cliente
+     * @param fuera Si no es nulo, recibe el cliente que salio
+     * @return true Si el cliente seguia en la fila
+     */
+    bool remove(ManejadorCliente h, Cliente* fuera = nullptr) {
+        if (!valido(h)) return false;
+        uint32_t r = static_cast<uint32_t>(h);
+        copiarAntes(r);
+        Cliente c = move(tabla[r]);
+        if (fuera != nullptr) *fuera = move(c);
+        quitarEn(posiciones[r]);
+        return true;
+    }
+
+    /**
+     * @brief Cliente que sigue en la fila. Si se cambia algo que afecte su prioridad hay que llamar update
+     * 
+     * @param h Manejador del cliente
+     * @return Cliente* nullptr si ya salio de la fila
+     */
+    Cliente* buscar(ManejadorCliente h) {
+        if (!valido(h)) return nullptr;
+        copiarAntes(static_cast<uint32_t>(h));
+        return &tabla[static_cast<uint32_t>(h)];
+    }
+
+    /**
+     * @brief Recalcula la prioridad de un cliente despues de cambiar su carrito o su condicion
+     * 
+     * @param h Manejador del cliente
+     * @return true Si el cliente seguia en la fila
+     */
+    bool update(ManejadorCliente h) {
+        if (!valido(h)) return false;
+        uint32_t r = static_cast<uint32_t>(h);
+        size_t i = posiciones[r];
+        uint64_t anterior = claves[i];
+        claves[i] = clave(tabla[r]);
+        if (claves[i] > anterior) subir(i);
+        else bajar(i);
+        return true;
+    }
+
+    /**
+     * @brief Cambia la politica de prioridad. Recalcula todas las claves y rearma el heap en O(n); se llama una vez, al
+     * configurar la fila
+     * 
+     * @param ns Espera en nanosegundos que vale un nivel de prioridad; 0 = prioridad estricta
+     */
+    void fijarEnvejecimiento(int64_t ns) {
+        nsPorNivel = max<int64_t>(ns, 0);
+        hayOrigen = nsPorNivel > 0 && !ranuras.empty();
+        if (hayOrigen) origenNs = tabla[ranuras.front()].llegadaNs;
+        for (size_t i = 0; i < claves.size(); ++i) claves[i] = clave(tabla[ranuras[i]]);
+        for (size_t i = claves.size(); i-- > 0;) bajar(i);
+    }
+
+    /**
+     * @brief Marca T0 de un punto de control: no copia nada, solo recuerda que ranuras habia (el hilo del punto de
+     * control las copia con copiarFoto y las cajas con copiarAntes)
+     * 
+     * @param p Punto de control que se esta tomando
+     */
+    void iniciarFoto(PuntoDeControl& p) {
+        foto = &p;
+        copiadas.assign(tabla.capacidad(), 0);
+        cursorFoto = 0;
+    }
+
+    /**
+     * @brief Copia un trozo de las ranuras de T0 que nadie ha tocado. Se llama con la fila bloqueada, un trozo a la vez
+     * 
+     * @param cuantas Ranuras que se revisan
+     * @return true Si ya se copiaron todas y el punto de control termino con la fila
+     */
+    bool copiarFoto(size_t cuantas) {
+        if (foto == nullptr) return true;
+        size_t fin = min(copiadas.size(), cursorFoto + cuantas);
+        for (; cursorFoto < fin; ++cursorFoto)
+            if (posiciones[cursorFoto] != FUERA) copiarAntes(static_cast<uint32_t>(cursorFoto));
+        if (cursorFoto < copiadas.size()) return false;
+        foto = nullptr;
+        vector<uint8_t>().swap(copiadas);
+        return true;
+    }
+
+    bool empty() const { return claves.empty(); }
+    size_t size() const { return claves.size(); }
+};
+
+/**
+ * @brief Histograma logaritmico-lineal (estilo HDR) de tiempos en nanosegundos: cada potencia de 2 se parte en 64 cubetas,
+ * asi el error relativo es menor a 1.6% desde 1 ns hasta siglos. Registrar es un clz, un corrimiento y una suma; no
+ * reserva memoria ni usa atomicos (cada caja tiene el suyo y al final se combinan)
+ * 
+ */
+class HistogramaHdr {
+private:
+    static const int BITS_SUB = 6;      // 64 cubetas por potencia de 2
+    static const size_t CUBETAS = (64 - BITS_SUB) * (size_t(1) << BITS_SUB) + (size_t(1) << (BITS_SUB + 1));
+    vector<uint64_t> cuentas = vector<uint64_t>(CUBETAS, 0);
+    uint64_t total = 0;
+    int64_t maximo = 0;
+
+    static size_t cubeta(uint64_t v) {
+        if (v < (uint64_t(1) << (BITS_SUB + 1))) return static_cast<size_t>(v);     // valores pequeños: exactos
+        int msb = 63 - __builtin_clzll(v);
+        int corrimiento = msb - BITS_SUB;
+        return (static_cast<size_t>(corrimiento) << BITS_SUB) + static_cast<size_t>(v >> corrimiento);
+    }
+
+    static uint64_t limiteInferior(size_t i) {      // menor valor que cae en la cubeta i
+        if (i < (size_t(1) << (BITS_SUB + 1))) return i;
+        size_t corrimiento = (i >> BITS_SUB) - 1;
+        uint64_t base = (i & ((size_t(1) << BITS_SUB) - 1)) + (uint64_t(1) << BITS_SUB);
+        return base << corrimiento;
+    }
+
+public:
+    /**
+     * @brief Registra un tiempo
+     * 
+     * @param ns Nanosegundos (los negativos cuentan como 0)
+     */
+    void registrar(int64_t ns) {
+        if (ns < 0) ns = 0;
+        ++cuentas[cubeta(static_cast<uint64_t>(ns))];
+        ++total;
+        if (ns > maximo) maximo = ns;
+    }
+
+    void combinar(const HistogramaHdr& otro) {      // suma otro histograma a este
+        for (size_t i = 0; i < CUBETAS; ++i) cuentas[i] += otro.cuentas[i];
+        total += otro.total;
+        maximo = max(maximo, otro.maximo);
+    }
+
+    uint64_t cantidad() const { return total; }
+    int64_t maximoNs() const { return maximo; }
+
+    /**
+     * @brief Percentil aproximado (limite inferior de la cubeta donde cae)
+     * 
+     * @param p Percentil entre 0 y 100
+     * @return int64_t Nanosegundos
+     */
+    int64_t percentil(double p) const {
+        if (total == 0) return 0;
+        uint64_t objetivo = max<uint64_t>(1, static_cast<uint64_t>(ceil(p / 100.0 * total)));
+        uint64_t acumulado = 0;
+        for (size_t i = 0; i < CUBETAS; ++i) {
+            acumulado += cuentas[i];
+            if (acumulado >= objetivo) return min(static_cast<int64_t>(limiteInferior(i)), maximo);
+        }
+        return maximo;
+    }
+
+    /**
+     * @brief Recorre las cubetas con datos
+     * 
+     * @param visitante Funcion (limite inferior en ns, cantidad)
+     */
+    template <class Visitante>
+    void recorrer(Visitante visitante) const {
+        for (size_t i = 0; i < CUBETAS; ++i)
+            if (cuentas[i] != 0) visitante(limiteInferior(i), cuentas[i]);
+    }
+};
+
+/**
+ * @brief Nombre de cada nivel de prioridad (indice nivelPrioridad - 1)
+ * 
+ */
+const char* const NOMBRES_NIVEL[3] = {"Carrito grande", "Carrito pequeño", "Atención especial"};
+
+/**
+ * @brief Espera (llegada -> inicio de atencion) y estancia (llegada -> salida) por nivel de prioridad
+ * 
+ */
+struct LatenciasPorNivel {
+    HistogramaHdr espera[3];
+    HistogramaHdr estancia[3];
+
+    void combinar(const LatenciasPorNivel& otra) {
+        for (int n = 0; n < 3; ++n) {
+            espera[n].combinar(otra.espera[n]);
+            estancia[n].combinar(otra.estancia[n]);
+        }
+    }
+
+    /**
+     * @brief Escribe todas las cubetas en CSV (nivel,metrica,desde_ns,cantidad) para analizarlas despues
+     * 
+     * @param ruta Archivo de salida
+     * @param error Mensaje si falla
+     * @return true Si se pudo escribir
+     */
+    bool volcar(const string& ruta, string& error) const {
+        ofstream archivo(ruta);
+        if (!archivo) {
+            error = "No se pudo crear " + ruta;
+            return false;
+        }
+        archivo << "nivel,metrica,desde_ns,cantidad\n";
+        for (int n = 3; n >= 1; --n) {
+            espera[n - 1].recorrer([&](uint64_t desde, uint64_t cantidad) {
+                archivo << NOMBRES_NIVEL[n - 1] << ",espera," << desde << "," << cantidad << "\n";
+            });
+            estancia[n - 1].recorrer([&](uint64_t desde, uint64_t cantidad) {
+                archivo << NOMBRES_NIVEL[n - 1] << ",estancia," << desde << "," << cantidad << "\n";
+            });
+        }
+        if (!archivo) error = "No se pudo escribir " + ruta;
+        return static_cast<bool>(archivo);
+    }
+
+    /**
+     * @brief Imprime en cout la tabla de percentiles por nivel y la espera maxima de cada clase (inanicion: lo que hay
+     * que mirar al ajustar el envejecimiento). Si se pidio --latencias tambien vuelca el CSV
+     * 
+     * @param nsPorUnidad Nanosegundos por unidad de la tabla (1e6 para ms, 1e9 para s)
+     * @param unidad Nombre de la unidad
+     */
+    void mostrar(double nsPorUnidad, const char* unidad) const {
+        auto enUnidad = [&](int64_t ns) { return ns / nsPorUnidad; };
+        auto nombreAlineado = [](int n) {
+            string nombre = NOMBRES_NIVEL[n - 1];
+            size_t ancho = static_cast<size_t>(count_if(nombre.begin(), nombre.end(), [](char ch) { return (ch & 0xC0) != 0x80; }));
+            nombre.append(ancho < 18 ? 18 - ancho : 0, ' ');        // se alinea por caracteres, no por bytes (tildes)
+            return nombre;
+        };
+        char linea[160];
+        snprintf(linea, sizeof(linea), "Tiempos por nivel (%s)%*sp50       p90       p99     p99.9    máximo\n",
+                 unidad, static_cast<int>(18 - strlen(unidad)), "");
+        cout << ANS_CYAN << linea << ANS_RESET;
+        for (int n = 3; n >= 1; --n) {
+            for (int metrica = 0; metrica < 2; ++metrica) {
+                const HistogramaHdr& h = metrica == 0 ? espera[n - 1] : estancia[n - 1];
+                if (h.cantidad() == 0) continue;
+                snprintf(linea, sizeof(linea), "  %s %-8s %9.3f %9.3f %9.3f %9.3f %9.3f  (%llu)\n",
+                         nombreAlineado(n).c_str(), metrica == 0 ? "espera" : "estancia", enUnidad(h.percentil(50)),
+                         enUnidad(h.percentil(90)), enUnidad(h.percentil(99)), enUnidad(h.percentil(99.9)), enUnidad(h.maximoNs()),
+                         static_cast<unsigned long long>(h.cantidad()));
+                cout << linea;
+            }
+        }
+        cout << "Inanición (espera máxima por clase):";
+        for (int n = 3; n >= 1; --n) {
+            if (espera[n - 1].cantidad() == 0) continue;
+            snprintf(linea, sizeof(linea), "  %s %.3f %s", NOMBRES_NIVEL[n - 1], enUnidad(espera[n - 1].maximoNs()), unidad);
+            cout << linea;
+        }
+        cout << "\n";
+        if (!opciones.rutaLatencias.empty()) {
+            string error;
+            if (!volcar(opciones.rutaLatencias, error)) cerr << ANS_RED << error << ANS_RESET << "\n";
+        }
+    }
+};
+
+
+/**
+ * @brief PROCESAR EL CARRITO (ASIGNAR PRECIOS Y GUARDAR FACTURA)
+ * 
+ * @param nombreCliente Nombre del cliente al que se le esta cobrando
+ * @param carrito Productos del carro (identificadores del catalogo), sin copiarlos: se cobran del tope al fondo
+ * @param ordenLlegada Orden de llegada del cliente (fija sus precios aleatorios)
+ * @param out Donde se imprime el detalle del cobro
+ * @return int Devuelve el precio total
+ */
+int procesarCarrito(string_view nombreCliente, VistaProductos carrito, int ordenLlegada, SalidaConsola& out = salida()) {
+    GeneradorXoshiro& generador = generadorPrecios();
+    motorPrecios.prepararCliente(generador, ordenLlegada);
+    int total = 0;      // sirve para obtener el precio total
+    ProductosFactura productosFactura(recursoActual());     //Declaracion de vectores que guarda pares conformados por el identificador y el precio del producto
+    productosFactura.reserve(carrito.size());       // una sola reserva por factura
+
+    out << ANS_YELLOW << "Procesando carrito...\n" << ANS_RESET;
+    for (auto it = carrito.rbegin(); it != carrito.rend(); ++it) {      // del tope al fondo, como si se sacaran de la pila
+        IdProducto producto = *it;
+        int precio = motorPrecios.precio(producto, generador);
+        if (out.activa()) out << " - " << catalogo().nombre(producto) << ": $" << precio << "\n";
+        total += precio;      //Se va acumulando el precio total en la variable total
+
+        productosFactura.emplace_back(producto, precio);     //Se guarda en el vector las el nombre y precio del producto
+    }
+
+
+    int64_t instante = instanteActualNs();      // solo se guarda el numero; el texto se arma al mostrar la factura
+
+    out << ANS_GREEN << "Total a pagar: $" << total << ANS_RESET << "\n";
+    out << "----------------------------------------\n";
+    pausa(450);
+
+
+    Factura nueva(nombreCliente, move(productosFactura), total, instante);       // Crear factura y almacenarla en la cola
+    registrarFactura(move(nueva));
+
+    return total;
+}
+
+
+/**
+ * @brief Anillo acotado de multiples productores y consumidores sin bloqueos (algoritmo de Vyukov). Cada celda tiene un
+ * numero de secuencia que indica si esta libre o lista; meter y sacar solo usan operaciones atomicas
+ * 
+ * @tparam T Tipo de dato que se guarda (se mueve al meter y al sacar)
+ */
+template <class T>
+class AnilloConcurrente {
+private:
+    struct Celda {
+        atomic<size_t> secuencia;
+        T dato;
+    };
+
+    unique_ptr<Celda[]> celdas;
+    size_t mascara;         // capacidad - 1 (la capacidad es potencia de 2)
+    alignas(64) atomic<size_t> posMeter{0};     // separados en lineas de cache distintas para no estorbarse
+    alignas(64) atomic<size_t> posSacar{0};
+
+public:
+    /**
+     * @brief Construye el anillo
+     * 
+     * @param capacidad Cantidad minima de celdas (se redondea a potencia de 2)
+     */
+    explicit AnilloConcurrente(size_t capacidad) {
+        size_t cap = 2;
+        while (cap < capacidad) cap <<= 1;
+        celdas.reset(new Celda[cap]);
+        mascara = cap - 1;
+        for (size_t i = 0; i < cap; ++i) celdas[i].secuencia.store(i, memory_order_relaxed);
+    }
+
+    /**
+     * @brief Intenta meter un dato
+     * 
+     * @param dato Dato que se mueve al anillo si hay espacio
+     * @return true Si se guardo
+     * @return false Si el anillo esta lleno
+     */
+    bool intentarMeter(T& dato) {
+        size_t pos = posMeter.load(memory_order_relaxed);
+        Celda* celda;
+        while (true) {
+            celda = &celdas[pos & mascara];
+            size_t sec = celda->secuencia.load(memory_order_acquire);
+            intptr_t dif = static_cast<intptr_t>(sec) - static_cast<intptr_t>(pos);
+            if (dif == 0) {
+                if (posMeter.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return false;       // lleno
+            } else {
+                pos = posMeter.load(memory_order_relaxed);
+            }
+        }
+        celda->dato = move(dato);
+        celda->secuencia.store(pos + 1, memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Intenta sacar el dato mas antiguo
+     * 
+     * @param dato Donde se deja el dato sacado
+     * @return true Si habia un dato listo
+     * @return false Si el anillo esta vacio
+     */
+    bool intentarSacar(T& dato) {
+        size_t pos = posSacar.load(memory_order_relaxed);
+        Celda* celda;
+        while (true) {
+            celda = &celdas[pos & mascara];
+            size_t sec = celda->secuencia.load(memory_order_acquire);
+            intptr_t dif = static_cast<intptr_t>(sec) - static_cast<intptr_t>(pos + 1);
+            if (dif == 0) {
+                if (posSacar.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return false;       // vacio
+            } else {
+                pos = posSacar.load(memory_order_relaxed);
+            }
+        }
+        dato = move(celda->dato);
+        celda->secuencia.store(pos + mascara + 1, memory_order_release);
+        return true;
+    }
+};
+
+
+/**
+ * @brief CLASE COLA CON PRIORIDAD (FILA DEL D1): simula la fila del supermercado pero con niveles de prioridad
+ * 
+ * @tparam Politica Regla de prioridad de la tienda (PoliticaD1 con sus constantes)
+ * @tparam Almacen Donde esperan los clientes: ColaPorNiveles (O(1), sin manejadores; abandonar y editarCarrito no compilan
+ * con ella) o HeapIndexado (O(log n), para quien necesite abandonar la fila o editar carritos con el cliente esperando)
+ */
+template <class Politica = PoliticaPorDefecto, template <class> class Almacen = ColaPorNiveles>
+class ColaPrioritariaD1 {
+private:
+    Almacen<Politica> cola;       //Cola con prioridad de clientes (mismo orden que ComparadorPrioridad<Politica>); con HeapIndexado cada cliente tiene un manejador para abandonar la fila o cambiar su carrito
+    atomic<int> contadorLlegadas{0};       //Contador para el orden de llegada de los clientes (atomico: varias terminales pueden dar turnos a la vez)
+    unique_ptr<AnilloConcurrente<Cliente>> llegadas;      // clientes que entraron por una terminal y aun no pasan a la fila (se crea en abrirLlegadas)
+    atomic<bool> llegadasAbiertas{false};       // true mientras alguna terminal pueda seguir trayendo clientes
+    atomic<int> llegadasEnCamino{0};        // terminales que ya tomaron turno y aun no dejan al cliente en el anillo
+
+    static const size_t LLEGADAS_POR_TERMINAL = 4096;       // celdas del anillo por cada terminal de entrada
+
+public:
+
+    /**
+     * @brief Agrega un cliente a la cola
+     * 
+     * @param nombre Nombre del cliente
+     * @param carrito Carro del cliente
+     * @param discapacidad Si el cliente presenta discapacidad
+     * @param adultoMayor Si el cliente es un adulto mayor
+     * @param embarazada Si el cliente esta embarazada
+     * @return ManejadorCliente Manejador del cliente mientras espera en la fila
+     */
+    ManejadorCliente agregarCliente(string nombre, CarritoDeCompras carrito,      // agrega un cliente a la cola
+                        bool discapacidad, bool adultoMayor, bool embarazada) {
+        return agregarCliente(Cliente(move(nombre), move(carrito), discapacidad, adultoMayor, embarazada, 0));
+    }
+
+    /**
+     * @brief Agrega un cliente ya armado a la cola, moviendolo (su orden de llegada se asigna aqui)
+     * 
+     * @param c Cliente que llega
+     * @param llegadaNs Instante de llegada; por defecto el reloj monotono (la simulacion por eventos pasa su reloj virtual)
+     * @param out Donde se anuncia la llegada (la simulacion por eventos no anuncia a nadie)
+     * @return ManejadorCliente Manejador del cliente mientras espera en la fila
+     */
+    ManejadorCliente agregarCliente(Cliente c, int64_t llegadaNs = -1, SalidaConsola& out = salida()) {
+        c.ordenLlegada = contadorLlegadas++;       // aumenta el contador de llegadas
+        c.llegadaNs = llegadaNs >= 0 ? llegadaNs : ahoraNs();
+        if (out.activa()) out << ANS_GREEN << " " << c.nombre << " ha llegado al D1 con " << c.carrito.size() << " productos." << ANS_RESET << "\n";       //Muestra el nombre del cliente y numero de productos
+        lock_guard<mutex> lock(mutexCola);
+        return cola.push(move(c));
+    }
+
+    /**
+     * @brief Agrega muchos clientes de una vez (por ejemplo de una importacion). Toman turnos consecutivos en el orden de
+     * la lista y la fila se arma una sola vez (heapify en HeapIndexado) en lugar de un push por cliente. No se anuncia
+     * cada llegada
+     * 
+     * @param lista Clientes que llegan juntos
+     */
+    void agregarClientes(vector<Cliente>&& lista) {
+        int primero = contadorLlegadas.fetch_add(static_cast<int>(lista.size()));
+        int64_t llegadaNs = ahoraNs();
+        for (size_t i = 0; i < lista.size(); ++i) {
+            lista[i].ordenLlegada = primero + static_cast<int>(i);
+            lista[i].llegadaNs = llegadaNs;
+        }
+        lock_guard<mutex> lock(mutexCola);
+        cola.cargar(move(lista));
+    }
+
+    /**
+     * @brief Un cliente que esta esperando se va sin pagar. Solo se puede con clientes que siguen en la fila: los que
+     * ya pasaron al lote de una caja (o los que entraron por una terminal y aun estan en el anillo) no tienen manejador
+     * 
+     * @param h Manejador que devolvio agregarCliente
+     * @return true Si el cliente seguia esperando y salio de la fila
+     */
+    bool abandonar(ManejadorCliente h) {
+        Cliente c;
+        {
+            lock_guard<mutex> lock(mutexCola);
+            if (!cola.remove(h, &c)) return false;
+        }
+        salida() << ANS_YELLOW << " " << c.nombre << " abandonó la fila." << ANS_RESET << "\n";
+        return true;
+    }
+
+    /**
+     * @brief Modifica el carrito de un cliente mientras espera y recalcula su prioridad (puede cruzar el limite de
+     * 5 productos en cualquier sentido)
+     * 
+     * @param h Manejador que devolvio agregarCliente
+     * @param editar Funcion que recibe el CarritoDeCompras& del cliente
+     * @return true Si el cliente seguia esperando
+     */
+    template <class Edicion>
+    bool editarCarrito(ManejadorCliente h, Edicion editar) {
+        lock_guard<mutex> lock(mutexCola);
+        Cliente* c = cola.buscar(h);
+        if (c == nullptr) return false;
+        editar(c->carrito);
+        cola.update(h);
+        return true;
+    }
+
+    /**
+     * @brief Agrega un producto al carrito de un cliente que esta esperando
+     * 
+     * @param h Manejador del cliente
+     * @param producto Nombre del producto
+     * @return true Si el cliente seguia esperando
+     */
+    bool agregarProducto(ManejadorCliente h, const string& producto) {
+        return editarCarrito(h, [&](CarritoDeCompras& carrito) { carrito.push(producto); });
+    }
+
+    /**
+     * @brief Quita el ultimo producto del carrito de un cliente que esta esperando
+     * 
+     * @param h Manejador del cliente
+     * @return true Si el cliente seguia esperando
+     */
+    bool quitarProducto(ManejadorCliente h) {
+        return editarCarrito(h, [](CarritoDeCompras& carrito) { carrito.pop(); });
+    }
+
+    /**
+     * @brief Indica que hay terminales de entrada trabajando: las cajas no terminan aunque la fila quede vacia. El anillo
+     * de llegadas se crea aqui, a la medida de las terminales (una fila sin terminales no lo necesita). Se llama antes de
+     * abrir las terminales y las cajas
+     * 
+     * @param terminales Cantidad de terminales que van a traer clientes
+     */
+    void abrirLlegadas(int terminales) {
+        if (!llegadas) llegadas.reset(new AnilloConcurrente<Cliente>(max(terminales, 1) * LLEGADAS_POR_TERMINAL));
+        llegadasAbiertas.store(true, memory_order_release);
+    }
+
+    /**
+     * @brief Indica que ya no llegaran mas clientes por las terminales
+     * 
+     */
+    void cerrarLlegadas() { llegadasAbiertas.store(false, memory_order_release); }
+
+    /**
+     * @brief Llegada desde una terminal de entrada mientras las cajas atienden (despues de abrirLlegadas). No usa mutex:
+     * el turno se toma con un contador atomico y el cliente pasa por el anillo de llegadas hasta que una caja lo mueve a
+     * la fila. Entre el turno y el anillo la llegada cuenta como "en camino" para que un punto de control no la pierda
+     * 
+     * @param c Cliente que llega (su orden de llegada se asigna aqui)
+     */
+    void recibirLlegada(Cliente c) {
+        while (true) {      // mismo acuerdo que las cajas: mientras un punto de control busca su T0 no se dan turnos
+            llegadasEnCamino.fetch_add(1);
+            if (!fotoPedida.load()) break;
+            llegadasEnCamino.fetch_sub(1);
+            esperarFoto();
+        }
+        c.ordenLlegada = contadorLlegadas.fetch_add(1, memory_order_relaxed);
+        c.llegadaNs = ahoraNs();
+        SalidaMemoria aviso(salida().activa());     // se arma antes de entregar el cliente y se escribe de una vez
+        aviso << ANS_GREEN << " " << c.nombre << " ha llegado al D1 con " << c.carrito.size() << " productos." << ANS_RESET << "\n";
+        while (!llegadas->intentarMeter(c)) this_thread::yield();       // anillo lleno: se espera a que las cajas lo vacien
+        llegadasEnCamino.fetch_sub(1, memory_order_release);
+        salida() << aviso.contenido();
+    }
+
+    /**
+     * @brief Funcion para saber si quedan clientes en la cola
+     * 
+     * @return true Si no hay mas clientes
+     * @return false Si quedan clientes
+     */
+    bool empty() const { return cola.empty(); }       //True si no hay mas clientes en la cola
+
+    /**
+     * @brief Politica de envejecimiento: un cliente sube un nivel de prioridad por cada "nsPorNivel" que lleve esperando,
+     * asi un carrito grande no espera para siempre detras de un flujo constante de clientes prioritarios
+     * 
+     * @param nsPorNivel Espera en nanosegundos que vale un nivel; 0 = prioridad estricta (el comportamiento de siempre)
+     */
+    void fijarEnvejecimiento(int64_t nsPorNivel) {
+        lock_guard<mutex> lock(mutexCola);
+        cola.fijarEnvejecimiento(nsPorNivel);
+    }
+
+    size_t size() const { return cola.size(); }       // clientes esperando en la fila
+
+    /**
+     * @brief Mete de una vez los clientes de un punto de control restaurado, con su orden de llegada original, y deja el
+     * contador donde iba para que los que lleguen despues queden detras de ellos
+     * 
+     * @param clientes Clientes que esperaban (su llegadaNs ya esta sobre el reloj actual)
+     * @param siguienteLlegada Contador de llegadas guardado en el punto de control
+     */
+    void restaurar(vector<Cliente>&& clientes, int siguienteLlegada) {
+        lock_guard<mutex> lock(mutexCola);
+        cola.cargar(move(clientes));
+        if (contadorLlegadas.load() < siguienteLlegada) contadorLlegadas.store(siguienteLlegada);
+    }
+
+    /**
+     * @brief Guarda puntos de control periodicos mientras se atiende (atenderClientes abre el hilo que los toma)
+     * 
+     * @param ruta Archivo del punto de control; vacio = ninguno
+     * @param intervaloNs Tiempo entre un punto de control y el siguiente
+     */
+    void programarPuntosDeControl(string ruta, int64_t intervaloNs) {
+        rutaPuntoControl = move(ruta);
+        intervaloPuntoNs = max<int64_t>(intervaloNs, 1000000);
+    }
+
+    /**
+     * @brief Guarda un punto de control de la fila, los lotes de las cajas y las facturas en memoria sin detener la
+     * atencion. En T0 se espera a que cada caja termine el cobro en curso y cada terminal deje en el anillo al cliente al
+     * que ya le dio turno, se bloquean la fila, los lotes y las facturas, y se escriben la cabecera y los lotes (pocos clientes). Despues todo se suelta: la fila se copia por trozos con
+     * copia al escribir y al archivo de facturas se le agregan solo las de T0 que no tenia (solo crecen por detras). Lo
+     * llama el hilo de puntos de control, o cualquiera mientras no se este atendiendo
+     * 
+     * @param ruta Archivo del punto de control
+     * @param error Mensaje si falla
+     * @return true Si el punto de control quedo escrito
+     */
+    bool guardarPuntoDeControl(const string& ruta, string& error) {
+        static const size_t TROZO = 4096;       // ranuras o facturas que se copian en cada bloqueo
+        PuntoDeControl foto;
+        if (!foto.abrir(ruta, error)) return false;
+        size_t enMemoria;
+        {
+            lock_guard<mutex> lock(mutexFacturas);
+            enMemoria = colaFacturas.size();
+        }
+        if (!facturasPunto.abrir(ruta, enMemoria, error)) return false;
+        int64_t inicioNs = ahoraNs();
+        size_t facturas;
+        fotoPedida.store(true);     // desde aqui ninguna terminal da turnos nuevos (ver recibirLlegada)
+        {
+            vector<unique_lock<mutex>> cobros, lotes;
+            if (cajasActivas != nullptr)
+                for (CajaRegistradora& caja : *cajasActivas) cobros.emplace_back(caja.cobro);
+            lock_guard<mutex> lockCola(mutexCola);
+            drenarLlegadas();
+            while (llegadasEnCamino.load() > 0) {       // turnos ya dados cuyo cliente aun no llega al anillo
+                this_thread::yield();
+                drenarLlegadas();       // tambien libera celdas si el anillo estaba lleno
+            }
+            size_t enLotes = 0;
+            if (cajasActivas != nullptr) {
+                for (CajaRegistradora& caja : *cajasActivas) {
+                    lotes.emplace_back(caja.m);
+                    enLotes += caja.lote.size();
+                }
+            }
+            lock_guard<mutex> lockFacturas(mutexFacturas);
+            facturas = colaFacturas.size();
+            foto.cabecera(static_cast<uint32_t>(contadorLlegadas.load()), motorPrecios.getSemilla(), cola.size() + enLotes, facturas,
+                          facturasPunto.getGeneracion());
+            if (cajasActivas != nullptr)
+                for (const CajaRegistradora& caja : *cajasActivas)
+                    for (const Cliente& c : caja.lote) foto.agregarCliente(c);
+            cola.iniciarFoto(foto);
+        }
+        fotoPedida.store(false, memory_order_release);
+        int64_t pausaNs = ahoraNs() - inicioNs;
+
+        bool listo = false;
+        while (!listo) {
+            {
+                lock_guard<mutex> lock(mutexCola);
+                listo = cola.copiarFoto(TROZO);
+            }
+            foto.vaciar();
+        }
+        uint64_t yaEscritas = facturasPunto.getEscritas();
+        for (size_t i = yaEscritas; i < facturas;) {
+            lock_guard<mutex> lock(mutexFacturas);
+            for (size_t fin = min(facturas, i + TROZO); i < fin; ++i) facturasPunto.agregar(colaFacturas[i]);
+        }
+        if (!facturasPunto.vaciar(error)) return false;     // las facturas quedan antes que el punto de control que las nombra
+        if (!foto.cerrar(ruta, error)) return false;
+        facturasPunto.confirmar();
+        ++puntosGuardados;
+        pausaMaximaNs = max(pausaMaximaNs, pausaNs);
+        ultimoPuntoClientes = foto.clientesCopiados();
+        ultimoPuntoFacturas = facturas;
+        ultimoPuntoFacturasNuevas = facturas - yaEscritas;
+        return true;
+    }
+
+    size_t getPuntosGuardados() const { return puntosGuardados; }
+    int64_t getPausaMaximaNs() const { return pausaMaximaNs; }      // lo mas que espero una caja por un punto de control
+    uint64_t getUltimoPuntoClientes() const { return ultimoPuntoClientes; }
+    uint64_t getUltimoPuntoFacturas() const { return ultimoPuntoFacturas; }
+    uint64_t getUltimoPuntoFacturasNuevas() const { return ultimoPuntoFacturasNuevas; }     // las que agrego al archivo de facturas
+
+    /**
+     * @brief Saca de la fila al cliente con mayor prioridad sin atenderlo (la simulacion por eventos decide cuando)
+     * 
+     * @param c Cliente que sale de la fila
+     * @return true Si habia alguien en la fila
+     */
+    bool sacarSiguiente(Cliente& c) {
+        lock_guard<mutex> lock(mutexCola);
+        if (cola.empty()) return false;
+        c = move(cola.top());
+        cola.pop();
+        return true;
+    }
+
+    /**
+     * @brief Funcion que atiende los clientes y los elimina de la cola
+     * 
+     * @param cajas Cantidad de cajas registradoras que atienden en paralelo
+     * @param latencias Si no es nulo, se le suman los tiempos de espera y estancia en lugar de imprimirlos (varias tiendas)
+     */
+    void atenderClientes(int cajas = 1, LatenciasPorNivel* latencias = nullptr) {
+        salida() << "\n" << ANS_BLUE << " INICIO DE ATENCIÓN EN D1 \n\n" << ANS_RESET;
+
+        vector<CajaRegistradora> registradoras(max(cajas, 1));
+        cajasActivas = &registradoras;
+        thread puntosDeControl;
+        if (!rutaPuntoControl.empty()) {
+            atencionTerminada = false;
+            puntosDeControl = thread([this]() { tomarPuntosDeControl(); });
+        }
+        if (cajas <= 1) {
+            while (true) {
+                bool abiertas = llegadasAbiertas.load(memory_order_acquire);        // se lee antes de drenar para no perder la ultima llegada
+                esperarFoto();
+                unique_lock<mutex> cobrando(registradoras[0].cobro);        // un punto de control no corta un cobro a la mitad
+                Cliente c;
+                bool hayCliente = false;
+                {
+                    lock_guard<mutex> lock(mutexCola);      // un cliente puede abandonar la fila mientras tanto
+                    drenarLlegadas();
+                    if (!cola.empty()) {
+                        c = move(cola.top());       //Obtiene el primer cliente de la cola (El de mayor prioridad) sin copiarlo
+                        cola.pop();       // Elimina el primer cliente de la cola
+                        hayCliente = true;
+                    }
+                }
+                if (!hayCliente) {
+                    if (!abiertas) break;
+                    cobrando.unlock();
+                    this_thread::yield();       // la fila esta vacia pero pueden llegar mas clientes
+                    continue;
+                }
+                atenderCliente(c, salida(), registradoras[0]);
+            }
+        } else {
+            atenderEnCajas(registradoras);
+        }
+        if (puntosDeControl.joinable()) {       // el ultimo punto de control queda con la fila vacia y todas las facturas
+            {
+                lock_guard<mutex> lock(mutexPuntos);
+                atencionTerminada = true;
+            }
+            avisoPuntos.notify_all();
+            puntosDeControl.join();
+            string error;
+            if (!guardarPuntoDeControl(rutaPuntoControl, error)) cerr << ANS_RED << error << ANS_RESET << "\n";
+        }
+        cajasActivas = nullptr;
+
+        salida() << ANS_YELLOW << " Todos los clientes han sido atendidos correctamente.\n" << ANS_RESET;
+        salida().vaciar();      // lo que siga se imprime directo en cout
+        if (latencias != nullptr) {
+            for (const CajaRegistradora& caja : registradoras) latencias->combinar(caja.latencias);
+        } else {
+            mostrarLatencias(registradoras);
+        }
+    }
+
+private:
+    /**
+     * @brief Caja registradora que trabaja en su propio hilo. Toma un lote pequeño de la fila compartida y, si se queda sin
+     * clientes, le roba la mitad del lote a la caja mas ocupada
+     * 
+     */
+    struct CajaRegistradora {
+        mutex m;                // protege el lote (la caja dueña lo saca por el frente, los ladrones por atras)
+        mutex cobro;            // tomado mientras la caja saca y cobra un cliente: el punto de control espera a que termine
+        deque<Cliente> lote;    // clientes asignados a la caja, en orden de prioridad
+        int numero = 0;         // numero que se muestra (0 si solo hay una caja)
+        size_t atendidos = 0;   // clientes que cobro esta caja
+        size_t robados = 0;     // clientes que le quito a otras cajas
+        LatenciasPorNivel latencias;    // espera y estancia de los clientes que atendio esta caja
+    };
+
+    mutex mutexCola;        // protege la fila compartida mientras las cajas trabajan
+    vector<CajaRegistradora>* cajasActivas = nullptr;       // cajas de la atencion en curso (sus lotes entran al punto de control)
+
+    string rutaPuntoControl;        // vacio = sin puntos de control periodicos
+    int64_t intervaloPuntoNs = 0;
+    mutex mutexPuntos;
+    condition_variable avisoPuntos;     // despierta al hilo de puntos de control cuando termina la atencion
+    bool atencionTerminada = false;
+    atomic<bool> fotoPedida{false};     // un punto de control espera su T0: las cajas le ceden el paso antes del siguiente cobro
+    size_t puntosGuardados = 0;
+    int64_t pausaMaximaNs = 0;
+    uint64_t ultimoPuntoClientes = 0, ultimoPuntoFacturas = 0, ultimoPuntoFacturasNuevas = 0;
+    FacturasPuntoControl facturasPunto;     // archivo de facturas de los puntos de control de esta fila
+
+    /**
+     * @brief Una caja que va a tomar otro cliente deja pasar primero al punto de control que lo esta esperando. Sin esto
+     * la caja vuelve a tomar su candado de cobro apenas lo suelta y el punto de control puede esperar mucho
+     * 
+     */
+    void esperarFoto() {
+        while (fotoPedida.load(memory_order_acquire)) this_thread::yield();
+    }
+
+    /**
+     * @brief Hilo de puntos de control: guarda uno cada intervalo hasta que termina la atencion
+     * 
+     */
+    void tomarPuntosDeControl() {
+        unique_lock<mutex> lock(mutexPuntos);
+        while (!avisoPuntos.wait_for(lock, chrono::nanoseconds(intervaloPuntoNs), [this]() { return atencionTerminada; })) {
+            lock.unlock();
+            string error;
+            if (!guardarPuntoDeControl(rutaPuntoControl, error)) cerr << ANS_RED << error << ANS_RESET << "\n";
+            lock.lock();
+        }
+    }
+
+    /**
+     * @brief Pasa a la fila todos los clientes que estan listos en el anillo de llegadas. Solo la llama quien tiene la fila
+     * 
+     */
+    void drenarLlegadas() {
+        if (!llegadas) return;
+        Cliente c;
+        while (llegadas->intentarSacar(c)) cola.push(move(c));
+    }
+
+    /**
+     * @brief Cobra a un cliente: muestra sus productos, procesa el carrito y deja la factura
+     * 
+     * @param c Cliente que se atiende
+     * @param out Donde se imprime la atencion
+     * @param caja Caja que lo atiende (acumula sus estadisticas)
+     */
+    void atenderCliente(Cliente& c, SalidaConsola& out, CajaRegistradora& caja) {
+        int64_t inicioNs = ahoraNs();
+        int nivel = Politica::nivel(c) - 1;      // antes de cobrar: el carrito queda vacio
+
+        out << ANS_MAGENTA << "Atendiendo a " << c.nombre << " (" << c.carrito.size() << " productos)";
+        if (c.discapacidad) out << " Discapacitado";
+        else if (c.adultoMayor) out << " Adulto Mayor";
+        else if (c.embarazada) out << " Embarazada"; // mostrar las razones de la prioridad
+        if (caja.numero > 0) out << " en la caja " << caja.numero;
+        out << ANS_RESET << "\n";
+        c.carrito.mostrarProductos(out); // imprime los productos
+        int total = procesarCarrito(c.nombre, c.carrito.verProductos(), c.ordenLlegada, out); // Procesa el carrito (los productos pasan a la factura)
+
+        out << ANS_GREEN << " " << c.nombre << " pagó $" << total << ANS_RESET << "\n\n";
+        ++caja.atendidos;
+        caja.latencias.espera[nivel].registrar(inicioNs - c.llegadaNs);
+        caja.latencias.estancia[nivel].registrar(ahoraNs() - c.llegadaNs);
+        // Pausa pequeña entre clientes para que sea legible
+        pausa(800);
+    }
+
+    /**
+     * @brief Pasa un lote de clientes de la fila compartida a una caja, en orden de prioridad. Antes mueve a la fila los
+     * clientes que esperan en el anillo de llegadas
+     * 
+     * @param caja Caja que se quedo sin clientes
+     * @param numCajas Total de cajas, para repartir la fila
+     * @return true Si la caja recibio clientes
+     */
+    bool rellenarLote(CajaRegistradora& caja, size_t numCajas) {
+        lock_guard<mutex> lockCola(mutexCola);
+        drenarLlegadas();
+        if (cola.empty()) return false;
+        size_t tam = min<size_t>(16, max<size_t>(1, cola.size() / (2 * numCajas)));       // lotes pequeños para respetar la prioridad
+        lock_guard<mutex> lockCaja(caja.m);
+        for (size_t i = 0; i < tam && !cola.empty(); ++i) {
+            caja.lote.push_back(move(cola.top()));
+            cola.pop();
+        }
+        return true;
+    }
+
+    /**
+     * @brief Roba la mitad final del lote de la caja con mas clientes pendientes
+     * 
+     * @param cajas Todas las cajas
+     * @param ladron Indice de la caja que roba
+     * @return true Si consiguio clientes
+     */
+    bool robarTrabajo(vector<CajaRegistradora>& cajas, size_t ladron) {
+        size_t victima = ladron;
+        size_t mayor = 0;
+        for (size_t i = 0; i < cajas.size(); ++i) {     // se busca la caja mas cargada (lectura aproximada sin bloquear todas)
+            if (i == ladron) continue;
+            lock_guard<mutex> lock(cajas[i].m);
+            if (cajas[i].lote.size() > mayor) {
+                mayor = cajas[i].lote.size();
+                victima = i;
+            }
+        }
+        if (victima == ladron) return false;
+
+        deque<Cliente> botin;
+        {
+            lock_guard<mutex> lock(cajas[victima].m);
+            size_t mitad = cajas[victima].lote.size() / 2;
+            if (mitad == 0 && !cajas[victima].lote.empty()) mitad = 1;
+            for (size_t i = 0; i < mitad; ++i) {        // los de menor prioridad del lote estan al final
+                botin.push_front(move(cajas[victima].lote.back()));
+                cajas[victima].lote.pop_back();
+            }
+        }
+        if (botin.empty()) return false;
+
+        lock_guard<mutex> lock(cajas[ladron].m);
+        cajas[ladron].robados += botin.size();
+        for (Cliente& c : botin) cajas[ladron].lote.push_back(move(c));
+        return true;
+    }
+
+    /**
+     * @brief Atiende la fila con varias cajas en paralelo (un hilo por caja)
+     * 
+     * @param cajas Cajas que van a atender
+     */
+    void atenderEnCajas(vector<CajaRegistradora>& cajas) {
+        Tienda* tienda = tiendaDelHilo;     // las cajas facturan en la tienda de quien las abre y reservan de su arena
+        pmr::memory_resource* recurso = recursoDelHilo;
+        auto trabajar = [&, tienda, recurso](size_t k) {
+            tiendaDelHilo = tienda;
+            recursoDelHilo = recurso;
+            CajaRegistradora& propia = cajas[k];
+            SalidaMemoria texto(salida().activa());
+            while (true) {
+                esperarFoto();
+                unique_lock<mutex> cobrando(propia.cobro);      // un punto de control no corta un cobro a la mitad
+                bool hayCliente = false;
+                Cliente c;
+                {
+                    lock_guard<mutex> lock(propia.m);
+                    if (!propia.lote.empty()) {
+                        c = move(propia.lote.front());
+                        propia.lote.pop_front();
+                        hayCliente = true;
+                    }
+                }
+                if (!hayCliente) {
+                    if (rellenarLote(propia, cajas.size()) || robarTrabajo(cajas, k)) continue;
+                    if (llegadasAbiertas.load(memory_order_acquire)) {     // la fila esta vacia pero las terminales siguen abiertas
+                        cobrando.unlock();
+                        this_thread::yield();
+                        continue;
+                    }
+                    if (rellenarLote(propia, cajas.size())) continue;      // ultimos clientes que quedaron en el anillo
+                    break;      // no queda nadie en la fila ni en otras cajas
+                }
+
+                texto.limpiar();
+                atenderCliente(c, texto, propia);
+                salida() << texto.contenido();      // cada cliente se imprime completo, sin mezclarse con otras cajas
+            }
+        };
+
+        vector<thread> hilos;
+        for (size_t k = 0; k < cajas.size(); ++k) {
+            cajas[k].numero = static_cast<int>(k) + 1;
+            hilos.emplace_back(trabajar, k);
+        }
+        for (thread& h : hilos) h.join();
+
+        for (const CajaRegistradora& caja : cajas)
+            salida() << ANS_CYAN << "Caja " << caja.numero << ": " << caja.atendidos << " clientes atendidos, "
+                 << caja.robados << " tomados de otras cajas" << ANS_RESET << "\n";
+    }
+
+    /**
+     * @brief Muestra la espera entre la terminal de entrada y la caja para los clientes que llegaron de forma concurrente
+     * 
+     * @param cajas Cajas que atendieron
+     */
+    void mostrarLatencias(const vector<CajaRegistradora>& cajas) const {
+        LatenciasPorNivel todas;
+        for (const CajaRegistradora& caja : cajas) todas.combinar(caja.latencias);
+        todas.mostrar(1e6, "ms");
+    }
+};
+
+/**
+ * @brief VISUALES ASCII: Pantallas
+ * 
+ * @param title 
+ */
+void printHeader(const string &title) {
+    const int WIDTH = 90;
+    cout << ANS_BOLD << ANS_BLUE;
+    cout << string(WIDTH, '=') << "\n";
+    int pad = (WIDTH - static_cast<int>(title.size())) / 2;
+    if (pad < 0) pad = 0;
+    cout << string(pad, ' ') << title << "\n";
+    cout << string(WIDTH, '=') << ANS_RESET << "\n";
+}
+
+/**
+ * @brief Escena 1: Pasillo con estantes (ASCII puro)
+ * 
+ */
+void pantallaInicio() {
+    clearScreen();
+    printHeader(" BIENVENIDO AL D1 - PASILLO PRINCIPAL ");
+
+    // Representacion de los articulos a comprar (son los mismos con que se llena el catalogo)
+    const string etiquetas[] = {"[ESTANTE SUPERIOR] ", "[ESTANTE MEDIO]    ", "[ESTANTE INFERIOR] "};
+    cout << "\n";
+    for (size_t e = 0; e < ESTANTES.size(); ++e) {
+        cout << ANS_YELLOW << etiquetas[e] << ANS_RESET;
+        for (const auto& articulo : ESTANTES[e])
+            cout << articulo.second << "[" << articulo.first << "] ";
+        cout << ANS_RESET << "\n\n";
+    }
+
+    // Explanatory text
+    cout << ANS_WHITE << "Modo: " << ANS_RESET;
+    cout << "Prueba rápida (clientes predefinidos) o crear tus propios clientes.\n\n";
+
+    cout << ANS_BOLD << "¿Deseas usar el modo de prueba (clientes predefinidos)? (S/N): " << ANS_RESET;
+    // Pregunta para empezar un modo precargado.
+}
+
+
+/**
+ * @brief Transicion
+ * 
+ */
+void pantallaIntermedia() {
+    clearScreen();
+    const string text = " INICIO DE ATENCIÓN EN D1 ";
+    const int WIDTH = 90;
+    // Simulate sliding from right to center slowly
+    for (int pos = WIDTH; pos >= (WIDTH - static_cast<int>(text.size())) / 2; pos -= 2) {
+        clearScreen();
+        printHeader("");
+        // print empty lines to center vertically a bit
+        cout << "\n\n\n";
+        int leftPad = max(0, pos);
+        cout << string(leftPad, ' ');
+        cout << ANS_BOLD << ANS_YELLOW << text << ANS_RESET << "\n\n\n";
+        pausa(120); // lento y vistoso
+    }
+
+    cout << "\n";               //Pequeña pausa
+    cout << ANS_CYAN << "Presiona Enter para comenzar la atención..." << ANS_RESET;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+
+    string dummy;
+    getline(cin, dummy);
+}
+
+/**
+ * @brief Escena 2: Caja registradora y cinta
+ * 
+ */
+void pantallaCaja() {
+    clearScreen();
+    printHeader(" CAJA REGISTRADORA - SECCIÓN DE ATENCIÓN ");
+    cout << "\n";
+
+    // Simple ASCII representation: cinta y caja
+    cout << ANS_WHITE << "Cinta transportadora:\n" << ANS_RESET;
+    cout << ANS_CYAN << "[====][====][====][====][====][====][====][====][====][====]" << ANS_RESET << "\n\n";
+
+    cout << ANS_BLUE << "   [CAJA]  " << ANS_RESET << "  Aquí se mostrará la atención a clientes y los mensajes.\n\n";
+
+    cout << ANS_GREEN << "Mensajes de atención aparecerán aquí mientras los clientes son procesados.\n\n" << ANS_RESET;
+    cout << ANS_BOLD << "Presiona Enter para comenzar a procesar la fila..." << ANS_RESET;
+    string dummy;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    getline(cin, dummy);
+}
+
+
+/**
+ * @brief Pantalla final
+ * 
+ */
+void pantallaFinal() {
+    clearScreen();
+    printHeader(" GRACIAS POR COMPRAR EN D1 ");
+    cout << "\n";
+    cout << ANS_YELLOW << ANS_BOLD;
+    slowPrint("Gracias por preferirnos. Esperamos verte pronto en D1.\n\n", 3);
+    cout << ANS_RESET;
+    cout << ANS_CYAN << "Pulse Enter para finalizar el programa..." << ANS_RESET;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    string dummy;
+    getline(cin, dummy);
+}
+
+
+/**
+ * @brief Pedirle al usuario un input que se volvera un string
+ * 
+ * @param prompt Mensaje que se muestra en la pantalla (En negrilla)
+ * @return string Devuelve el nombre
+ */
+string askLine(const string &prompt) {
+    cout << ANS_BOLD << prompt << ANS_RESET;
+    string line;
+    getline(cin, line);       //Con getline los espacios tambien se guarden
+    return line;
+}
+
+/**
+ * @brief 
+ * 
+ * @param prompt Preguntar al usuario si (s) o no (n) (acepta minusculas y mayusculas en la entrada)
+ * @return true En caso de que diga si(s)
+ * @return false En caso de que diga no (n)
+ */
+bool askYesNo(const string &prompt) {
+    while (true) {
+        cout << ANS_BOLD << prompt << " (S/N): " << ANS_RESET;
+        string resp;
+        getline(cin, resp);
+        if (resp.empty()) continue;
+        char c = toupper(static_cast<unsigned char>(resp[0]));        //toupper Permite usar mayusculas y minusculas
+        if (c == 'S') return true;
+        if (c == 'N') return false;
+        cout << ANS_RED << "Entrada no válida. Por favor escribe 'S' o 'N'." << ANS_RESET << "\n";
+    }
+}
+
+/**
+ * @brief Pregunta los atributos de propridad de un cliente y los agrupa en un vector: discapacidad, adultoMayor, embarazada (booleanos)
+ * 
+ * @return tuple<bool,bool,bool> Representa las posibles causas de prioridad del cliente
+ */
+tuple<bool,bool,bool> askPriorityFlags() {        // Pregunta los atributos de propridad de un cliente y los agrupa en un vector: discapacidad, adultoMayor, embarazada (booleanos)
+    cout << ANS_WHITE << "Selecciona si el cliente tiene alguna condición especial:\n" << ANS_RESET;
+    cout << "  1) Discapacidad\n";
+    cout << "  2) Adulto mayor\n";
+    cout << "  3) Embarazada\n";
+    cout << "  4) Ninguna de las anteriores\n";
+    while (true) {
+        cout << ANS_BOLD << "Ingresa el número de la opción (1-4): " << ANS_RESET;
+        string opt;
+        getline(cin, opt);
+        if (opt.empty()) continue;
+        if (opt == "1") return {true, false, false};
+        if (opt == "2") return {false, true, false};
+        if (opt == "3") return {false, false, true};
+        if (opt == "4") return {false, false, false};
+        cout << ANS_RED << "Opción inválida. Intenta de nuevo.\n" << ANS_RESET;
+    }
+}
+
+/**
+ * @brief Funcion que devuelve un cliente creado por el usuario
+ * 
+ * @param ordenIdx Orden de entrada
+ * @return Cliente Devuelve el cliente generado por el usuario
+ */
+Cliente buildClientInteractive(int ordenIdx) {
+    string nombre;
+    while (true) {
+        nombre = askLine("Nombre del cliente: ");       //Pedir el nombre del cliente hasta que se deje de escribir un texto vacio
+        if (!nombre.empty()) break;
+        cout << ANS_RED << "El nombre no puede estar vacío.\n" << ANS_RESET;
+    }
+
+    CarritoDeCompras carrito(nombre);       //Crea el carrito de compras que va a tener el cliente (actua como una pila)
+    cout << ANS_CYAN
+     << "Ingresa productos para el carrito. Escribe una línea vacía para terminar.\n"
+     << "Si te equivocas, escribe 'BORRAR', 'ELIMINAR' o 'DESHACER' para eliminar el último producto.\n"
+     << ANS_RESET;
+
+while (true) {
+    string prod = askLine("  Producto (Enter para terminar): ");
+    if (prod.empty()) break;  // salir si el usuario presiona solo Enter
+
+    string mayus = prod;         // Permitir eliminar el último producto
+    for (char &c : mayus) c = toupper(static_cast<unsigned char>(c));
+    if (mayus == "BORRAR" || mayus == "ELIMINAR" || mayus == "DESHACER") {
+        carrito.pop();
+        continue;       // saltar al siguiente ciclo
+    }
+
+    carrito.push(prod);       // Si no escribió "BORRAR", agregar normalmente
+}
+
+    auto [dis, ad, emb] = askPriorityFlags();       //Guarda los valores de la tupla en 3 variables (dis, ad, emb)
+    return Cliente(move(nombre), move(carrito), dis, ad, emb, ordenIdx);       //Devuelve el cliente creado
+}
+
+
+/**
+ * @brief Cantidad de clientes distintos del modo de prueba
+ * 
+ */
+const size_t CLIENTES_DEMO = 5;
+
+/**
+ * @brief Crea uno de los clientes predefinidos del modo de prueba. Si i supera los 5 clientes base se repiten en orden con un numero para distinguirlos
+ * 
+ * @param i Indice del cliente (Sofía, Carlos, Marta, Ana, Luis, Sofía #6, ...)
+ * @return Cliente Cliente con su carrito lleno (el orden de llegada lo asigna la fila)
+ */
+Cliente crearClienteDemo(size_t i) {
+    static const vector<string> nombresBase = {"Sofía", "Carlos", "Marta", "Ana", "Luis"};
+    // los productos se buscan en el catalogo una sola vez: con --tiendas cada hilo arma miles de estos carritos y buscar
+    // el nombre en cada push toma el candado compartido del catalogo
+    static const vector<vector<IdProducto>> carritosBase = []() {
+        const vector<vector<string>> productos = {
+            {"Huevos", "Leche", "Pan"},         // Sofía
+            {"Café", "Queso", "Pan integral"},      // Carlos
+            {"Yogurt", "Manzanas", "Galletas", "Agua"},     // Marta
+            {"Leche", "Pan", "Huevos"},         // Ana
+            {"Arroz", "Aceite", "Azúcar", "Lentejas", "Cereal", "Papel higiénico"}      // Luis
+        };
+        vector<vector<IdProducto>> ids(productos.size());
+        for (size_t c = 0; c < productos.size(); ++c)
+            for (const string& producto : productos[c]) ids[c].push_back(catalogo().registrar(producto));
+        return ids;
+    }();
+    string nombre = nombresBase[i % CLIENTES_DEMO];
+    if (i >= CLIENTES_DEMO) nombre += " #" + to_string(i + 1);
+
+    CarritoDeCompras carrito(nombre);
+    for (IdProducto producto : carritosBase[i % CLIENTES_DEMO]) carrito.push(producto);
+    bool dis = false, ad = false, emb = false;
+    switch (i % CLIENTES_DEMO) {
+        case 0:     // Cliente Sofía (discapacidad)
+            dis = true;
+            break;
+        case 1:     // Cliente Carlos (adulto mayor)
+            ad = true;
+            break;
+        case 2:     // Cliente Marta (embarazada)
+            emb = true;
+            break;
+        default:    // Ana (pocos productos) y Luis (carro grande) no tienen prioridad especial
+            break;
+    }
+    return Cliente(move(nombre), move(carrito), dis, ad, emb, 0);
+}
+
+/**
+ * @brief Agrega a la fila uno de los clientes predefinidos del modo de prueba
+ * 
+ * @param fila Cola donde se agrega el cliente
+ * @param i Indice del cliente
+ */
+void agregarClienteDemo(ColaPrioritariaD1<>& fila, size_t i) {
+    fila.agregarCliente(crearClienteDemo(i));
+}
+
+/**
+ * @brief Imprime el encabezado de una factura
+ * 
+ * @param numero Numero consecutivo de la factura
+ * @param cliente Nombre del cliente
+ * @param fecha Fecha y hora
+ */
+void imprimirEncabezadoFactura(int numero, string_view cliente, string_view fecha) {
+    cout << ANS_YELLOW << "Factura #" << numero << ANS_RESET << "\n";
+    cout << "Cliente: " << cliente << "\n";
+    cout << "Fecha y hora: " << fecha << "\n";
+    cout << "Productos:\n";
+}
+
+/**
+ * @brief Imprime el total y el separador de una factura
+ * 
+ * @param total Valor pagado
+ */
+void imprimirTotalFactura(int64_t total) {
+    cout << ANS_GREEN << "Total: $" << total << ANS_RESET << "\n";
+    cout << "----------------------------------------\n";
+}
+
+/**
+ * @brief Muestra todas las facturas de la corrida: las lee del diario si se uso uno, o vacia la cola global
+ * 
+ */
+void imprimirFacturas() {
+    cout << "\n" << ANS_BOLD << ANS_BLUE << "FACTURAS GENERADAS:\n" << ANS_RESET;
+    int contador = 1;
+
+    if (!opciones.rutaDiario.empty()) {     // las facturas estan en el diario, no en memoria
+        terminarFacturacion();
+        LectorDiario lector;
+        string error;
+        bool ok = lector.abrir(opciones.rutaDiario, error) && lector.recorrer([&](const FacturaLeida& f) {
+            imprimirEncabezadoFactura(contador++, f.nombreCliente, f.fechaHora());
+            for (uint32_t i = 0; i < f.cantidad; ++i) {
+                auto p = f.producto(i);
+                cout << "  - " << lector.nombreProducto(p.first) << ": $" << p.second << "\n";
+            }
+            imprimirTotalFactura(f.total);
+        }, error, diarioFacturas.getInicioCorrida());
+        if (!ok) cerr << ANS_RED << error << ANS_RESET << "\n";
+        return;
+    }
+
+    while (!colaFacturas.empty()) { // mientras la cola no este vacia
+        Factura f = move(colaFacturas.front()); // obtiene el primer puesto sin copiarlo
+        colaFacturas.pop_front(); // elimina el primer puesto
+
+        imprimirEncabezadoFactura(contador++, f.nombreCliente, f.fechaHora());
+        for (auto &p : f.productos) {
+        cout << "  - " << catalogo().nombre(p.first) << ": $" << p.second << "\n";
+        }
+        imprimirTotalFactura(f.total);
+    }
+}
+
+/**
+ * @brief Cuenta las facturas de la corrida y suma lo cobrado (del diario o vaciando la cola global)
+ * 
+ * @param facturas Cantidad de facturas
+ * @param recaudo Total cobrado
+ * @return true Si se pudieron leer
+ */
+bool resumirFacturas(size_t& facturas, long long& recaudo) {
+    facturas = 0;
+    recaudo = 0;
+    if (!opciones.rutaDiario.empty()) {
+        terminarFacturacion();
+        LectorDiario lector;
+        string error;
+        bool ok = lector.abrir(opciones.rutaDiario, error) && lector.recorrer([&](const FacturaLeida& f) {
+            ++facturas;
+            recaudo += f.total;
+        }, error, diarioFacturas.getInicioCorrida());
+        if (!ok) cerr << ANS_RED << error << ANS_RESET << "\n";
+        return ok;
+    }
+    while (!colaFacturas.empty()) {
+        recaudo += colaFacturas.front().total;
+        colaFacturas.pop_front();
+        ++facturas;
+    }
+    return true;
+}
+
+/**
+ * @brief Analisis fuera de linea de un diario de facturas: totales y productos que mas venden
+ * 
+ * @param ruta Diario a analizar
+ * @return int 0 si se pudo leer, 1 si no
+ */
+int analizarDiario(const string& ruta) {
+    struct VentasProducto {
+        string_view nombre;
+        size_t unidades = 0;
+        long long recaudo = 0;
+    };
+    LectorDiario lector;
+    string error;
+    size_t facturas = 0, unidades = 0;
+    long long recaudo = 0;
+    // por nombre: cada corrida agregada al diario escribe sus 'P' con sus propios identificadores, asi que el nombre se
+    // resuelve al visitar la factura, cuando los 'P' recorridos son los de su corrida
+    unordered_map<string_view, VentasProducto> porNombre;
+
+    bool ok = lector.abrir(ruta, error) && lector.recorrer([&](const FacturaLeida& f) {
+        ++facturas;
+        recaudo += f.total;
+        unidades += f.cantidad;
+        for (uint32_t i = 0; i < f.cantidad; ++i) {
+            auto p = f.producto(i);
+            string_view nombre = lector.nombreProducto(p.first);
+            VentasProducto& v = porNombre[nombre];
+            v.nombre = nombre;
+            ++v.unidades;
+            v.recaudo += p.second;
+        }
+    }, error);
+    if (!ok) {
+        cerr << ANS_RED << error << ANS_RESET << "\n";
+        return 1;
+    }
+
+    cout << ANS_BOLD << ANS_BLUE << "ANÁLISIS DEL DIARIO " << ruta << "\n" << ANS_RESET;
+    cout << "Facturas: " << facturas << "\n";
+    cout << "Productos vendidos: " << unidades << "\n";
+    cout << "Total recaudado: $" << recaudo << "\n";
+    if (facturas > 0) cout << "Valor promedio por factura: $" << recaudo / static_cast<long long>(facturas) << "\n";
+
+    vector<VentasProducto> ventas;
+    ventas.reserve(porNombre.size());
+    for (const auto& par : porNombre) ventas.push_back(par.second);
+    sort(ventas.begin(), ventas.end(), [](const VentasProducto& a, const VentasProducto& b) { return a.recaudo > b.recaudo; });
+    cout << "Productos con mayor recaudo:\n";
+    for (size_t i = 0; i < ventas.size() && i < 5 && ventas[i].unidades > 0; ++i)
+        cout << "  " << i + 1 << ". " << (ventas[i].nombre.empty() ? string_view("(sin nombre)") : ventas[i].nombre) << ": " << ventas[i].unidades
+             << " unidades, $" << ventas[i].recaudo << "\n";
+    return 0;
+}
+
+/**
+ * @brief Muestra la forma de uso del programa desde la linea de comandos
+ * 
+ * @param programa Nombre del ejecutable
+ */
+void mostrarAyuda(const string& programa) {
+    cout << "Uso: " << programa << " [opciones]\n"
+         << "  (sin opciones)     Modo interactivo con pantallas\n"
+         << "  --headless         Modo por lotes: sin pantallas, pausas ni preguntas\n"
+         << "  --clientes N       Clientes a simular en modo headless (por defecto 100000)\n"
+         << "  --cajas N          Cajas registradoras que atienden en paralelo (por defecto 1)\n"
+         << "  --terminales N     Terminales de entrada que traen clientes mientras las cajas atienden (headless)\n"
+         << "  --tiendas N        Simula N tiendas a la vez, cada una con --clientes clientes, su fila, sus cajas y sus facturas\n"
+         << "  --hilos N          Hilos que se reparten las tiendas (por defecto uno por núcleo)\n"
+         << "  --afinidad         Fija cada hilo de tiendas a un núcleo (Linux)\n"
+         << "  --traza RUTA       Reproduce una traza de llegadas (nombre;prioridad 1-4;productos separados por |;llegada en µs), en headless\n"
+         << "  --importar RUTA    Importa los clientes de un CSV (nombre,prioridad 1-4,productos separados por |) o de un\n"
+         << "                     JSON ([{\"nombre\",\"prioridad\",\"productos\":[...]}]) y los mete juntos a la fila (headless)\n"
+         << "  --generar          Clientes sintéticos en lugar de los de prueba (headless)\n"
+         << "  --perfil-carga P   Distribuciones de la carga sintética: discapacidad=F,adulto=F,embarazada=F,express=F,\n"
+         << "                     max=N,zipf=S,catalogo=N,tasa=clientes/s (por ejemplo express=0.6,zipf=1.2)\n"
+         << "  --generar-traza RUTA  Escribe --clientes clientes sintéticos como traza de llegadas y termina\n"
+         << "  --simular          Simulación por eventos con reloj virtual (clientes de --traza o del generador de carga)\n"
+         << "  --tiempo-base S    Segundos de atención por cliente en la simulación (por defecto 15)\n"
+         << "  --tiempo-producto S  Segundos por producto escaneado en la simulación (por defecto 2)\n"
+         << "  --envejecimiento S Cada S segundos de espera un cliente sube un nivel de prioridad (por defecto 0: prioridad estricta)\n"
+         << "  --punto-control RUTA  Guarda la fila y las facturas periódicamente mientras se atiende (headless)\n"
+         << "  --intervalo-control S  Segundos entre puntos de control (por defecto 1)\n"
+         << "  --restaurar RUTA   Retoma la fila y las facturas de un punto de control en lugar de llenar la fila\n"
+         << "  --latencias RUTA   Guarda los histogramas de espera y estancia por nivel en CSV\n"
+         << "  --arena A          Memoria de carritos, clientes y facturas en headless: ninguna, monotona o pool (por defecto pool, o ninguna con --tiendas)\n"
+         << "  --precios RUTA     Tabla de precios en CSV (nombre,precio); los demas productos tienen precio aleatorio\n"
+         << "  --semilla N        Semilla de los precios aleatorios, para repetir una corrida\n"
+         << "  --diario RUTA      Escribe las facturas en un diario binario en lugar de guardarlas en memoria\n"
+         << "  --leer-diario RUTA Analiza un diario de facturas existente y termina\n"
+         << "  --contrapresion P  Si el escritor del diario se atrasa: esperar (por defecto), descartar o sincrono\n"
+         << "  --capacidad-escritor N  Facturas en espera por caja antes de aplicar la contrapresión (por defecto 4096)\n"
+         << "  --salida S         Salida de la atención: terminal, buffer o nula (por defecto terminal; buffer en headless, nula con --tiendas)\n"
+         << "  --ayuda            Muestra este mensaje\n";
+}
 
 /**
- * @brief Escena 2: Caja registradora y cinta
+ * @brief Lee las opciones de la linea de comandos y las guarda en la variable global opciones
  * 
+ * @param argc Cantidad de argumentos
+ * @param argv Argumentos
+ * @return true Si los argumentos son validos
+ * @return false Si hay un argumento desconocido o mal escrito
  */
-void pantallaCaja() {
-    clearScreen();
-    printHeader(" CAJA REGISTRADORA - SECCIÓN DE ATENCIÓN ");
-    cout << "\n";
+bool leerOpciones(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--ayuda" || arg == "-h") {
+            opciones.ayuda = true;
+        } else if (arg == "--headless") {
+            opciones.headless = true;
+        } else if (arg == "--clientes" && i + 1 < argc) {
+            try {
+                long long n = stoll(argv[++i]);
+                if (n <= 0) throw invalid_argument("clientes");
+                opciones.clientes = static_cast<size_t>(n);
+            } catch (const exception&) {
+                cerr << "Valor inválido para --clientes: " << argv[i] << "\n";
+                return false;
+            }
+        } else if (arg == "--cajas" && i + 1 < argc) {
+            try {
+                int n = stoi(argv[++i]);
+                if (n <= 0) throw invalid_argument("cajas");
+                opciones.cajas = n;
+            } catch (const exception&) {
+                cerr << "Valor inválido para --cajas: " << argv[i] << "\n";
+                return false;
+            }
+        } else if (arg == "--terminales" && i + 1 < argc) {
+            try {
+                int n = stoi(argv[++i]);
+                if (n < 0) throw invalid_argument("terminales");
+                opciones.terminales = n;
+            } catch (const exception&) {
+                cerr << "Valor inválido para --terminales: " << argv[i] << "\n";
+                return false;
+            }
+        } else if ((arg == "--tiendas" || arg == "--hilos") && i + 1 < argc) {
+            try {
+                long long n = stoll(argv[++i]);
+                if (n <= 0) throw invalid_argument("tiendas");
+                if (arg == "--tiendas") opciones.tiendas = static_cast<size_t>(n);
+                else opciones.hilos = static_cast<int>(n);
+            } catch (const exception&) {
+                cerr << "Valor inválido para " << arg << ": " << argv[i] << "\n";
+                return false;
+            }
+            opciones.headless = true;
+        } else if (arg == "--afinidad") {
+            opciones.afinidad = true;
+        } else if (arg == "--diario" && i + 1 < argc) {
+            opciones.rutaDiario = argv[++i];
+        } else if (arg == "--leer-diario" && i + 1 < argc) {
+            opciones.rutaAnalisis = argv[++i];
+        } else if (arg == "--contrapresion" && i + 1 < argc) {
+            opciones.contrapresion = argv[++i];
+            if (opciones.contrapresion != "esperar" && opciones.contrapresion != "descartar" && opciones.contrapresion != "sincrono") {
+                cerr << "Valor inválido para --contrapresion: " << opciones.contrapresion << "\n";
+                return false;
+            }
+        } else if (arg == "--capacidad-escritor" && i + 1 < argc) {
+            try {
+                long long n = stoll(argv[++i]);
+                if (n <= 0) throw invalid_argument("capacidad");
+                opciones.capacidadEscritor = static_cast<size_t>(n);
+            } catch (const exception&) {
+                cerr << "Valor inválido para --capacidad-escritor: " << argv[i] << "\n";
+                return false;
+            }
+        } else if (arg == "--salida" && i + 1 < argc) {
+            opciones.salida = argv[++i];
+            if (opciones.salida != "terminal" && opciones.salida != "buffer" && opciones.salida != "nula") {
+                cerr << "Valor inválido para --salida: " << opciones.salida << "\n";
+                return false;
+            }
+        } else if (arg == "--traza" && i + 1 < argc) {
+            opciones.rutaTraza = argv[++i];
+            opciones.headless = true;       // la traza reemplaza a los clientes de prueba y a las preguntas
+        } else if (arg == "--importar" && i + 1 < argc) {
+            opciones.rutaImportar = argv[++i];
+            opciones.headless = true;
+        } else if (arg == "--generar") {
+            opciones.generar = true;
+            opciones.headless = true;
+        } else if (arg == "--perfil-carga" && i + 1 < argc) {
+            opciones.perfilCarga = argv[++i];
+        } else if (arg == "--generar-traza" && i + 1 < argc) {
+            opciones.rutaGenerarTraza = argv[++i];
+        } else if (arg == "--simular") {
+            opciones.simular = true;
+            opciones.headless = true;
+        } else if ((arg == "--tiempo-base" || arg == "--tiempo-producto" || arg == "--envejecimiento") && i + 1 < argc) {
+            try {
+                double s = stod(argv[++i]);
+                if (s < 0) throw invalid_argument("tiempo");
+                (arg == "--tiempo-base" ? opciones.tiempoBase : arg == "--tiempo-producto" ? opciones.tiempoProducto : opciones.envejecimiento) = s;
+            } catch (const exception&) {
+                cerr << "Valor inválido para " << arg << ": " << argv[i] << "\n";
+                return false;
+            }
+        } else if (arg == "--punto-control" && i + 1 < argc) {
+            opciones.rutaPuntoControl = argv[++i];
+            opciones.headless = true;
+        } else if (arg == "--restaurar" && i + 1 < argc) {
+            opciones.rutaRestaurar = argv[++i];
+            opciones.headless = true;
+        } else if (arg == "--intervalo-control" && i + 1 < argc) {
+            try {
+                double s = stod(argv[++i]);
+                if (s <= 0) throw invalid_argument("intervalo");
+                opciones.intervaloPuntoControl = s;
+            } catch (const exception&) {
+                cerr << "Valor inválido para --intervalo-control: " << argv[i] << "\n";
+                return false;
+            }
+        } else if (arg == "--latencias" && i + 1 < argc) {
+            opciones.rutaLatencias = argv[++i];
+        } else if (arg == "--arena" && i + 1 < argc) {
+            opciones.arena = argv[++i];
+            if (opciones.arena != "ninguna" && opciones.arena != "monotona" && opciones.arena != "pool") {
+                cerr << "Valor inválido para --arena: " << opciones.arena << "\n";
+                return false;
+            }
+        } else if (arg == "--precios" && i + 1 < argc) {
+            opciones.rutaPrecios = argv[++i];
+        } else if (arg == "--semilla" && i + 1 < argc) {
+            try {
+                opciones.semilla = stoull(argv[++i]);
+            } catch (const exception&) {
+                cerr << "Valor inválido para --semilla: " << argv[i] << "\n";
+                return false;
+            }
+        } else {
+            cerr << "Opción desconocida: " << arg << "\n";
+            return false;
+        }
+    }
+    if (opciones.tiendas > 1 && (opciones.simular || opciones.terminales > 0 || !opciones.rutaDiario.empty())) {
+        cerr << "--tiendas no se puede usar con --simular, --terminales ni --diario\n";
+        return false;
+    }
+    if (!opciones.rutaImportar.empty() && (!opciones.rutaTraza.empty() || opciones.terminales > 0 || opciones.tiendas > 1 || opciones.simular)) {
+        cerr << "--importar no se puede usar con --traza, --terminales, --tiendas ni --simular\n";
+        return false;
+    }
+    if ((!opciones.rutaPuntoControl.empty() || !opciones.rutaRestaurar.empty()) && (opciones.tiendas > 1 || opciones.simular)) {
+        cerr << "--punto-control y --restaurar no se pueden usar con --tiendas ni --simular\n";
+        return false;
+    }
+    return true;
+}
 
-    // Simple ASCII representation: cinta y caja
-    cout << ANS_WHITE << "Cinta transportadora:\n" << ANS_RESET;
-    cout << ANS_CYAN << "[====][====][====][====][====][====][====][====][====][====]" << ANS_RESET << "\n\n";
+/**
+ * @brief Parametros de la carga sintetica. Las fracciones de atencion especial son excluyentes (como en askPriorityFlags)
+ * 
+ */
+struct ParametrosCarga {
+    double discapacidad = 0.03;     // fraccion de clientes con discapacidad
+    double adultoMayor = 0.12;      // fraccion de adultos mayores
+    double embarazada = 0.02;       // fraccion de embarazadas
+    double express = 0.45;          // fraccion de carritos con menos de 5 productos (nivel 2 de nivelPrioridad)
+    int maxProductos = 30;          // tamaño maximo de un carrito grande
+    double zipf = 1.0;              // exponente de popularidad: el producto k se elige con peso 1/k^zipf
+    size_t productosCatalogo = 0;   // productos del catalogo sobre los que se sortea; 0 = los que ya existen
+    double tasaLlegadas = 0.02;     // clientes por segundo (llegadas de Poisson): uno cada 50 s en promedio
+};
 
-    cout << ANS_BLUE << "   [CAJA]  " << ANS_RESET << "  Aquí se mostrará la atención a clientes y los mensajes.\n\n";
+/**
+ * @brief Generador de clientes sinteticos para pruebas de carga. Cada cliente depende solo de la semilla y de su
+ * indice, asi varias terminales pueden generar a la vez y la traza escrita reproduce los mismos clientes
+ * 
+ */
+class GeneradorCarga {
+private:
+    ParametrosCarga p;
+    uint64_t semilla = 1;
+    vector<double> acumulada;       // distribucion acumulada de Zipf por identificador de producto
 
-    cout << ANS_GREEN << "Mensajes de atención aparecerán aquí mientras los clientes son procesados.\n\n" << ANS_RESET;
-    cout << ANS_BOLD << "Presiona Enter para comenzar a procesar la fila..." << ANS_RESET;
-    string dummy;
-    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-    getline(cin, dummy);
-}
+    /**
+     * @brief Sortea un cliente
+     * 
+     * @param i Indice del cliente
+     * @param carrito Productos del fondo al tope
+     * @return char Opcion de prioridad 1-4 como en askPriorityFlags
+     */
+    char sortear(size_t i, vector<IdProducto>& carrito) const {
+        GeneradorXoshiro gen(semilla ^ (static_cast<uint64_t>(i) * 0x9E3779B97F4A7C15ULL));
+        double u = gen.uniforme();
+        char opcion = '4';
+        if (u < p.discapacidad) opcion = '1';
+        else if (u < p.discapacidad + p.adultoMayor) opcion = '2';
+        else if (u < p.discapacidad + p.adultoMayor + p.embarazada) opcion = '3';
+
+        int productos = (gen.uniforme() < p.express) ? gen.entre(1, 4) : gen.entre(5, max(5, p.maxProductos));
+        carrito.clear();
+        for (int k = 0; k < productos; ++k) {
+            size_t id = upper_bound(acumulada.begin(), acumulada.end(), gen.uniforme() * acumulada.back()) - acumulada.begin();
+            carrito.push_back(static_cast<IdProducto>(min(id, acumulada.size() - 1)));
+        }
+        return opcion;
+    }
+
+public:
+    /**
+     * @brief Lee un perfil "clave=valor,clave=valor". Claves: discapacidad, adulto, embarazada, express, max, zipf,
+     * catalogo y tasa
+     * 
+     * @param texto Perfil
+     * @param error Mensaje si hay una clave o valor invalido
+     * @return true Si el perfil es valido
+     */
+    bool leerPerfil(const string& texto, string& error) {
+        ParametrosCarga leido = p;
+        string_view resto = texto;
+        while (!resto.empty()) {
+            size_t coma = resto.find(',');
+            string_view par = resto.substr(0, coma);
+            resto.remove_prefix(coma == string_view::npos ? resto.size() : coma + 1);
+            size_t igual = par.find('=');
+            if (igual == string_view::npos) {
+                error = "se esperaba clave=valor en el perfil: " + string(par);
+                return false;
+            }
+            string clave(par.substr(0, igual));
+            double valor;
+            try {
+                size_t usado = 0;
+                string numero(par.substr(igual + 1));
+                valor = stod(numero, &usado);
+                if (usado != numero.size() || valor < 0) throw invalid_argument(clave);
+            } catch (const exception&) {
+                error = "valor inválido para " + clave + " en el perfil";
+                return false;
+            }
+            if (clave == "discapacidad") leido.discapacidad = valor;
+            else if (clave == "adulto") leido.adultoMayor = valor;
+            else if (clave == "embarazada") leido.embarazada = valor;
+            else if (clave == "express") leido.express = valor;
+            else if (clave == "max") leido.maxProductos = static_cast<int>(valor);
+            else if (clave == "zipf") leido.zipf = valor;
+            else if (clave == "catalogo") leido.productosCatalogo = static_cast<size_t>(valor);
+            else if (clave == "tasa") leido.tasaLlegadas = valor;
+            else {
+                error = "clave desconocida en el perfil: " + clave;
+                return false;
+            }
+        }
+        if (leido.discapacidad + leido.adultoMayor + leido.embarazada > 1 || leido.express > 1) {
+            error = "las fracciones del perfil no pueden sumar más de 1";
+            return false;
+        }
+        if (leido.tasaLlegadas <= 0) {
+            error = "la tasa de llegadas debe ser positiva";
+            return false;
+        }
+        if (leido.productosCatalogo > MAX_PRODUCTOS_DIARIO) {       // el diario no podria leer sus identificadores
+            error = "el catálogo del perfil no puede pasar de " + to_string(MAX_PRODUCTOS_DIARIO) + " productos";
+            return false;
+        }
+        p = leido;
+        return true;
+    }
+
+    /**
+     * @brief Prepara la distribucion de productos. Si el perfil pide mas productos que los del catalogo se registran
+     * productos sinteticos ("Producto N")
+     * 
+     * @param semillaCarga Semilla de la carga
+     */
+    void preparar(uint64_t semillaCarga) {
+        semilla = semillaCarga;
+        for (size_t k = catalogo().size(); k < p.productosCatalogo; ++k) catalogo().registrar("Producto " + to_string(k + 1));
+        size_t n = p.productosCatalogo > 0 ? p.productosCatalogo : catalogo().size();
+        acumulada.resize(n);
+        double suma = 0;
+        for (size_t k = 0; k < n; ++k) acumulada[k] = (suma += 1.0 / pow(static_cast<double>(k + 1), p.zipf));
+    }
+
+    /**
+     * @brief Arma el i-esimo cliente sintetico
+     * 
+     * @param i Indice del cliente
+     * @return Cliente Cliente con su carrito (el orden de llegada lo asigna la fila)
+     */
+    Cliente cliente(size_t i) const {
+        vector<IdProducto> productos;
+        char opcion = sortear(i, productos);
+        PilaProductos carrito(productos.begin(), productos.end());
+        string nombre = "Cliente " + to_string(i + 1);
+        CarritoDeCompras c(nombre, move(carrito));
+        return Cliente(move(nombre), move(c), opcion == '1', opcion == '2', opcion == '3', 0);
+    }
+
+    GeneradorXoshiro generadorLlegadas() const { return GeneradorXoshiro(semilla ^ 0xA5A5A5A5A5A5A5A5ULL); }      // sortea los tiempos entre llegadas
+
+    /**
+     * @brief Tiempo hasta la siguiente llegada (exponencial, llegadas de Poisson)
+     * 
+     * @param gen Generador devuelto por generadorLlegadas
+     * @return double Microsegundos
+     */
+    double separacionUs(GeneradorXoshiro& gen) const { return -log(1.0 - gen.uniforme()) * 1e6 / p.tasaLlegadas; }
+
+    /**
+     * @brief Escribe n clientes sinteticos como traza de llegadas (formato de TrazaLlegadas), con llegadas de Poisson
+     * 
+     * @param ruta Archivo de salida
+     * @param n Cantidad de clientes
+     * @param error Mensaje si falla
+     * @return true Si se pudo escribir
+     */
+    bool escribirTraza(const string& ruta, size_t n, string& error) const {
+        FILE* archivo = fopen(ruta.c_str(), "wb");
+        if (archivo == nullptr) {
+            error = "No se pudo crear " + ruta;
+            return false;
+        }
+        const size_t TAM_BLOQUE = 1 << 20;
+        string bloque;
+        bloque.reserve(TAM_BLOQUE + 4096);
+        bloque += "# nombre;prioridad;productos;llegada_us\n";
+
+        vector<string_view> nombres(acumulada.size());       // sin candado del catalogo por producto escrito
+        for (size_t k = 0; k < nombres.size(); ++k) nombres[k] = catalogo().nombre(static_cast<IdProducto>(k));
+
+        GeneradorXoshiro llegadas = generadorLlegadas();
+        vector<IdProducto> productos;
+        double instanteUs = 0;
+        char numero[24];
+        bool ok = true;
+        for (size_t i = 0; i < n && ok; ++i) {
+            char opcion = sortear(i, productos);
+            instanteUs += separacionUs(llegadas);
+
+            bloque += "Cliente ";
+            bloque.append(numero, to_chars(numero, numero + sizeof(numero), i + 1).ptr);
+            bloque += ';';
+            bloque += opcion;
+            bloque += ';';
+            for (size_t k = 0; k < productos.size(); ++k) {
+                if (k > 0) bloque += '|';
+                bloque += nombres[productos[k]];
+            }
+            bloque += ';';
+            bloque.append(numero, to_chars(numero, numero + sizeof(numero), static_cast<int64_t>(instanteUs)).ptr);
+            bloque += '\n';
+            if (bloque.size() >= TAM_BLOQUE) {
+                ok = fwrite(bloque.data(), 1, bloque.size(), archivo) == bloque.size();
+                bloque.clear();
+            }
+        }
+        if (ok) ok = fwrite(bloque.data(), 1, bloque.size(), archivo) == bloque.size();
+        if (fclose(archivo) != 0) ok = false;
+        if (!ok) error = "No se pudo escribir " + ruta;
+        return ok;
+    }
+};
 
+GeneradorCarga generadorCarga;      // carga sintetica de --generar y --generar-traza
 
 /**
- * @brief Pantalla final
+ * @brief Arena elegida con --arena para las corridas headless
  * 
+ * @return ArenaCorrida::Tipo Tipo de arena
  */
-void pantallaFinal() {
-    clearScreen();
-    printHeader(" GRACIAS POR COMPRAR EN D1 ");
-    cout << "\n";
-    cout << ANS_YELLOW << ANS_BOLD;
-    slowPrint("Gracias por preferirnos. Esperamos verte pronto en D1.\n\n", 3);
-    cout << ANS_RESET;
-    cout << ANS_CYAN << "Pulse Enter para finalizar el programa..." << ANS_RESET;
-    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-    string dummy;
-    getline(cin, dummy);
+ArenaCorrida::Tipo tipoArena() {
+    if (opciones.arena == "ninguna") return ArenaCorrida::Tipo::Ninguna;
+    if (opciones.arena == "monotona") return ArenaCorrida::Tipo::Monotona;
+    return ArenaCorrida::Tipo::Pool;
 }
 
-
 /**
- * @brief Pedirle al usuario un input que se volvera un string
+ * @brief Parametros de la simulacion por eventos: tiempo de atencion = base + productos * escaneo
  * 
- * @param prompt Mensaje que se muestra en la pantalla (En negrilla)
- * @return string Devuelve el nombre
  */
-string askLine(const string &prompt) {
-    cout << ANS_BOLD << prompt << ANS_RESET;
-    string line;
-    getline(cin, line);       //Con getline los espacios tambien se guarden
-    return line;
-}
+struct ParametrosSimulacion {
+    int64_t tiempoBaseUs = 15000000;        // saludo, pago y empaque
+    int64_t tiempoProductoUs = 2000000;     // escanear un producto
+    int64_t envejecimientoUs = 0;           // espera que vale un nivel de prioridad; 0 = prioridad estricta
+};
 
 /**
- * @brief 
+ * @brief Simulacion por eventos discretos con reloj virtual. Los eventos (llegada, inicio y fin de atencion) salen de un
+ * heap ordenado por instante; ColaPrioritariaD1 es la fila de espera. No hay pausas: una jornada completa se simula en
+ * milisegundos y se leen los tiempos de espera de cada nivel de prioridad
  * 
- * @param prompt Preguntar al usuario si (s) o no (n) (acepta minusculas y mayusculas en la entrada)
- * @return true En caso de que diga si(s)
- * @return false En caso de que diga no (n)
  */
-bool askYesNo(const string &prompt) {
-    while (true) {
-        cout << ANS_BOLD << prompt << " (S/N): " << ANS_RESET;
-        string resp;
-        getline(cin, resp);
-        if (resp.empty()) continue;
-        char c = toupper(static_cast<unsigned char>(resp[0]));        //toupper Permite usar mayusculas y minusculas
-        if (c == 'S') return true;
-        if (c == 'N') return false;
-        cout << ANS_RED << "Entrada no válida. Por favor escribe 'S' o 'N'." << ANS_RESET << "\n";
+class SimulacionEventos {
+public:
+    /**
+     * @brief Estadisticas de espera de un nivel de prioridad (tiempo virtual)
+     * 
+     */
+    struct EsperaNivel {
+        size_t atendidos = 0;
+        int64_t sumaEsperaUs = 0;
+        int64_t maxEsperaUs = 0;
+    };
+
+private:
+    enum class TipoEvento : uint8_t { Llegada, InicioAtencion, FinAtencion };
+
+    struct Evento {
+        int64_t instanteUs;
+        uint64_t secuencia;     // desempata eventos del mismo instante en el orden en que se programaron
+        TipoEvento tipo;
+        int caja;
+        int64_t duracionUs;     // en FinAtencion: tiempo que duro la atencion
+
+        bool operator>(const Evento& o) const {
+            return instanteUs != o.instanteUs ? instanteUs > o.instanteUs : secuencia > o.secuencia;
+        }
+    };
+
+    ParametrosSimulacion p;
+    ColaPrioritariaD1<> fila;
+    SalidaNula sinAvisos;       // las llegadas en tiempo virtual no se imprimen: solo cuenta el resumen
+    priority_queue<Evento, vector<Evento>, greater<Evento>> eventos;
+    uint64_t secuencia = 0;
+    int64_t relojUs = 0;
+    vector<int> cajasLibres;
+    vector<int64_t> ocupadaUs;      // tiempo atendiendo de cada caja
+    EsperaNivel niveles[3];
+    LatenciasPorNivel histogramas;      // espera y estancia en tiempo virtual (ns), para los percentiles y la inanicion
+    size_t maxFila = 0;
+
+    void programar(int64_t instanteUs, TipoEvento tipo, int caja = -1, int64_t duracionUs = 0) {
+        eventos.push(Evento{instanteUs, secuencia++, tipo, caja, duracionUs});
+    }
+
+    void ocuparCajaLibre() {        // si hay una caja libre, empieza a atender ahora mismo
+        if (cajasLibres.empty()) return;
+        int caja = cajasLibres.back();
+        cajasLibres.pop_back();
+        programar(relojUs, TipoEvento::InicioAtencion, caja);
+    }
+
+public:
+    explicit SimulacionEventos(const ParametrosSimulacion& parametros) : p(parametros) {
+        fila.fijarEnvejecimiento(p.envejecimientoUs * 1000);
+    }
+
+    /**
+     * @brief Corre la simulacion completa
+     * 
+     * @param clientes Cantidad de clientes
+     * @param cajas Cajas registradoras
+     * @param llegada Funcion (i) -> pair<Cliente, instante de llegada en µs> con llegadas no decrecientes
+     */
+    template <class FuenteLlegadas>
+    void correr(size_t clientes, int cajas, FuenteLlegadas llegada) {
+        cajasLibres.clear();
+        for (int k = cajas - 1; k >= 0; --k) cajasLibres.push_back(k);
+        ocupadaUs.assign(cajas, 0);
+
+        size_t siguiente = 0;       // las llegadas se piden de una en una: en memoria solo esta la fila
+        Cliente pendiente;
+        int64_t llegadaPendienteUs = 0;
+        auto pedirLlegada = [&]() {
+            if (siguiente >= clientes) return;
+            auto [c, instanteUs] = llegada(siguiente++);
+            pendiente = move(c);
+            llegadaPendienteUs = instanteUs;
+            programar(instanteUs, TipoEvento::Llegada);
+        };
+        pedirLlegada();
+
+        while (!eventos.empty()) {
+            Evento e = eventos.top();
+            eventos.pop();
+            relojUs = e.instanteUs;
+            switch (e.tipo) {
+                case TipoEvento::Llegada:
+                    fila.agregarCliente(move(pendiente), llegadaPendienteUs * 1000, sinAvisos);
+                    maxFila = max(maxFila, fila.size());
+                    ocuparCajaLibre();
+                    pedirLlegada();
+                    break;
+                case TipoEvento::InicioAtencion: {
+                    Cliente c;
+                    if (!fila.sacarSiguiente(c)) {      // nadie esperando: la caja queda libre
+                        cajasLibres.push_back(e.caja);
+                        break;
+                    }
+                    int n = nivelPrioridad(c) - 1;
+                    EsperaNivel& nivel = niveles[n];
+                    int64_t esperaUs = relojUs - c.llegadaNs / 1000;
+                    ++nivel.atendidos;
+                    nivel.sumaEsperaUs += esperaUs;
+                    nivel.maxEsperaUs = max(nivel.maxEsperaUs, esperaUs);
+                    int64_t duracionUs = p.tiempoBaseUs + static_cast<int64_t>(c.carrito.size()) * p.tiempoProductoUs;
+                    histogramas.espera[n].registrar(esperaUs * 1000);
+                    histogramas.estancia[n].registrar((esperaUs + duracionUs) * 1000);
+                    programar(relojUs + duracionUs, TipoEvento::FinAtencion, e.caja, duracionUs);
+                    break;
+                }
+                case TipoEvento::FinAtencion:
+                    ocupadaUs[e.caja] += e.duracionUs;
+                    programar(relojUs, TipoEvento::InicioAtencion, e.caja);     // la caja llama al siguiente
+                    break;
+            }
+        }
     }
+
+    int64_t duracionUs() const { return relojUs; }         // instante virtual del ultimo evento
+    const EsperaNivel& espera(int nivel) const { return niveles[nivel - 1]; }
+    const LatenciasPorNivel& latencias() const { return histogramas; }
+    size_t maximoEnFila() const { return maxFila; }
+
+    double utilizacion() const {        // fraccion del tiempo que las cajas estuvieron atendiendo
+        if (relojUs == 0 || ocupadaUs.empty()) return 0;
+        int64_t total = 0;
+        for (int64_t o : ocupadaUs) total += o;
+        return static_cast<double>(total) / (static_cast<double>(relojUs) * ocupadaUs.size());
+    }
+};
+
+/**
+ * @brief Tiempo virtual en texto hh:mm:ss
+ * 
+ * @param us Microsegundos
+ * @return string Texto
+ */
+string formatearDuracion(int64_t us) {
+    int64_t s = us / 1000000;
+    char texto[32];
+    snprintf(texto, sizeof(texto), "%02lld:%02lld:%02lld", static_cast<long long>(s / 3600),
+             static_cast<long long>(s / 60 % 60), static_cast<long long>(s % 60));
+    return texto;
 }
 
 /**
- * @brief Pregunta los atributos de propridad de un cliente y los agrupa en un vector: discapacidad, adultoMayor, embarazada (booleanos)
+ * @brief Modo de simulacion por eventos: los clientes salen de la traza o del generador de carga y se atienden en tiempo
+ * virtual
  * 
- * @return tuple<bool,bool,bool> Representa las posibles causas de prioridad del cliente
+ * @return int 0 si la simulacion corrio, 1 si no se pudo leer la traza
  */
-tuple<bool,bool,bool> askPriorityFlags() {        // Pregunta los atributos de propridad de un cliente y los agrupa en un vector: discapacidad, adultoMayor, embarazada (booleanos)
-    cout << ANS_WHITE << "Selecciona si el cliente tiene alguna condición especial:\n" << ANS_RESET;
-    cout << "  1) Discapacidad\n";
-    cout << "  2) Adulto mayor\n";
-    cout << "  3) Embarazada\n";
-    cout << "  4) Ninguna de las anteriores\n";
-    while (true) {
-        cout << ANS_BOLD << "Ingresa el número de la opción (1-4): " << ANS_RESET;
-        string opt;
-        getline(cin, opt);
-        if (opt.empty()) continue;
-        if (opt == "1") return {true, false, false};
-        if (opt == "2") return {false, true, false};
-        if (opt == "3") return {false, false, true};
-        if (opt == "4") return {false, false, false};
-        cout << ANS_RED << "Opción inválida. Intenta de nuevo.\n" << ANS_RESET;
+int ejecutarSimulacion() {
+    ArenaCorrida arena(tipoArena(), false);     // se declara primero: se destruye despues de todo lo que reservo
+    TrazaLlegadas traza;
+    bool usarTraza = !opciones.rutaTraza.empty();
+    if (usarTraza) {
+        string error;
+        if (!traza.cargar(opciones.rutaTraza, error)) {
+            cerr << ANS_RED << error << ANS_RESET << "\n";
+            return 1;
+        }
+        opciones.clientes = traza.size();
+    }
+
+    GeneradorXoshiro llegadas = generadorCarga.generadorLlegadas();
+    double instanteUs = 0;
+    auto fuente = [&](size_t i) -> pair<Cliente, int64_t> {
+        if (usarTraza) return {traza.cliente(i), traza.llegadaUs(i)};
+        instanteUs += generadorCarga.separacionUs(llegadas);
+        return {generadorCarga.cliente(i), static_cast<int64_t>(instanteUs)};
+    };
+
+    ParametrosSimulacion parametros;
+    parametros.tiempoBaseUs = static_cast<int64_t>(opciones.tiempoBase * 1e6);
+    parametros.tiempoProductoUs = static_cast<int64_t>(opciones.tiempoProducto * 1e6);
+    parametros.envejecimientoUs = static_cast<int64_t>(opciones.envejecimiento * 1e6);
+    SimulacionEventos simulacion(parametros);
+    auto inicio = chrono::steady_clock::now();
+    simulacion.correr(opciones.clientes, opciones.cajas, fuente);
+    chrono::duration<double> segundos = chrono::steady_clock::now() - inicio;
+    salida().vaciar();
+
+    cout << "\n" << ANS_BOLD << ANS_BLUE << "SIMULACIÓN POR EVENTOS\n" << ANS_RESET;
+    cout << "Clientes: " << opciones.clientes << "\n";
+    cout << "Cajas: " << opciones.cajas << "\n";
+    cout << "Jornada simulada: " << formatearDuracion(simulacion.duracionUs()) << "\n";
+    cout << "Utilización de las cajas: " << simulacion.utilizacion() * 100 << "%\n";
+    cout << "Máximo de clientes en fila: " << simulacion.maximoEnFila() << "\n";
+    for (int nivel = 3; nivel >= 1; --nivel) {
+        const SimulacionEventos::EsperaNivel& e = simulacion.espera(nivel);
+        if (e.atendidos == 0) continue;
+        cout << "  " << NOMBRES_NIVEL[nivel - 1] << ": " << e.atendidos << " clientes, espera promedio "
+             << formatearDuracion(e.sumaEsperaUs / static_cast<int64_t>(e.atendidos)) << ", máxima "
+             << formatearDuracion(e.maxEsperaUs) << "\n";
     }
+    if (opciones.envejecimiento > 0) cout << "Envejecimiento: un nivel de prioridad cada " << opciones.envejecimiento << " s de espera\n";
+    simulacion.latencias().mostrar(1e9, "s");
+    cout << ANS_GREEN << "Tiempo real de la simulación: " << segundos.count() << " s" << ANS_RESET << "\n";
+    return 0;
 }
 
 /**
- * @brief Funcion que devuelve un cliente creado por el usuario
+ * @brief Modo headless: llena la fila con clientes de prueba y los atiende sin pantallas ni pausas, midiendo el rendimiento
  * 
- * @param ordenIdx Orden de entrada
- * @return Cliente Devuelve el cliente generado por el usuario
+ * @return int 0
  */
-Cliente buildClientInteractive(int ordenIdx) {
-    string nombre;
-    while (true) {
-        nombre = askLine("Nombre del cliente: ");       //Pedir el nombre del cliente hasta que se deje de escribir un texto vacio
-        if (!nombre.empty()) break;
-        cout << ANS_RED << "El nombre no puede estar vacío.\n" << ANS_RESET;
+int ejecutarHeadless() {
+    ArenaCorrida arena(tipoArena(), opciones.cajas > 1 || opciones.terminales > 0);      // se declara primero: se destruye despues de la fila y las facturas
+    ColaPrioritariaD1<> fila;
+    fila.fijarEnvejecimiento(static_cast<int64_t>(opciones.envejecimiento * 1e9));
+    if (!opciones.rutaPuntoControl.empty())
+        fila.programarPuntosDeControl(opciones.rutaPuntoControl, static_cast<int64_t>(opciones.intervaloPuntoControl * 1e9));
+    chrono::duration<double> segundos;
+
+    size_t restaurados = 0;     // clientes que venian esperando en el punto de control
+    if (!opciones.rutaRestaurar.empty()) {
+        string error;
+        EstadoPuntoDeControl estado;
+        auto inicioRestaurar = chrono::steady_clock::now();
+        if (!PuntoDeControl::leer(opciones.rutaRestaurar, estado, error)) {
+            cerr << ANS_RED << error << ANS_RESET << "\n";
+            return 1;
+        }
+        motorPrecios.fijarSemilla(estado.semilla);      // los clientes restaurados se cobran como en la corrida original
+        size_t facturas = estado.facturas.size();
+        for (Factura& f : estado.facturas) registrarFactura(move(f));
+        restaurados = estado.clientes.size();
+        fila.restaurar(move(estado.clientes), static_cast<int>(estado.contadorLlegadas));
+        chrono::duration<double> restauracion = chrono::steady_clock::now() - inicioRestaurar;
+        cout << "Punto de control " << opciones.rutaRestaurar << ": " << restaurados << " clientes en fila y " << facturas
+             << " facturas restaurados en " << restauracion.count() * 1000 << " ms\n";
     }
 
-    CarritoDeCompras carrito(nombre);       //Crea el carrito de compras que va a tener el cliente (actua como una pila)
-    cout << ANS_CYAN
-     << "Ingresa productos para el carrito. Escribe una línea vacía para terminar.\n"
-     << "Si te equivocas, escribe 'BORRAR', 'ELIMINAR' o 'DESHACER' para eliminar el último producto.\n"
-     << ANS_RESET;
+    ImportacionClientes importacion;
+    if (!opciones.rutaImportar.empty()) {       // los clientes del archivo entran juntos a la fila
+        string error;
+        auto inicioCarga = chrono::steady_clock::now();
+        if (!importacion.cargar(opciones.rutaImportar, error)) {
+            cerr << ANS_RED << error << ANS_RESET << "\n";
+            return 1;
+        }
+        chrono::duration<double> carga = chrono::steady_clock::now() - inicioCarga;
+        opciones.clientes = importacion.size();
+        cout << "Importación: " << importacion.size() << " clientes leídos en " << carga.count() << " s\n";
+    }
 
-while (true) {
-    string prod = askLine("  Producto (Enter para terminar): ");
-    if (prod.empty()) break;  // salir si el usuario presiona solo Enter
+    TrazaLlegadas traza;
+    if (!opciones.rutaTraza.empty()) {      // los clientes salen de la traza en lugar de los de prueba
+        string error;
+        auto inicioCarga = chrono::steady_clock::now();
+        if (!traza.cargar(opciones.rutaTraza, error)) {
+            cerr << ANS_RED << error << ANS_RESET << "\n";
+            return 1;
+        }
+        chrono::duration<double> carga = chrono::steady_clock::now() - inicioCarga;
+        opciones.clientes = traza.size();
+        cout << "Traza: " << traza.size() << " clientes cargados en " << carga.count() << " s\n";
+    }
+    bool usarTraza = !opciones.rutaTraza.empty();
+    auto siguienteCliente = [&traza, usarTraza](size_t i) {
+        if (usarTraza) return traza.cliente(i);
+        return opciones.generar ? generadorCarga.cliente(i) : crearClienteDemo(i);
+    };
+
+    if (opciones.terminales == 0) {     // la fila se llena completa antes de abrir las cajas (o ya viene del punto de control)
+        if (!opciones.rutaImportar.empty()) {
+            fila.agregarClientes(importacion.clientes());       // una sola carga de la fila, sin un push por cliente
+        } else if (opciones.rutaRestaurar.empty()) {
+            for (size_t i = 0; i < opciones.clientes; ++i)
+                fila.agregarCliente(siguienteCliente(i));
+        } else {
+            opciones.clientes = 0;
+        }
 
-    string mayus = prod;         // Permitir eliminar el último producto
-    for (char &c : mayus) c = toupper(static_cast<unsigned char>(c));
-    if (mayus == "BORRAR" || mayus == "ELIMINAR" || mayus == "DESHACER") {
-        carrito.pop();
-        continue;       // saltar al siguiente ciclo
+        auto inicio = chrono::steady_clock::now();
+        fila.atenderClientes(opciones.cajas);
+        segundos = chrono::steady_clock::now() - inicio;
+    } else {        // las terminales de entrada y las cajas trabajan al mismo tiempo
+        auto inicio = chrono::steady_clock::now();
+        fila.abrirLlegadas(opciones.terminales);
+        thread entrada([&fila, &siguienteCliente]() {
+            vector<thread> terminales;
+            for (int t = 0; t < opciones.terminales; ++t) {
+                terminales.emplace_back([&fila, &siguienteCliente, t]() {
+                    for (size_t i = t; i < opciones.clientes; i += opciones.terminales)
+                        fila.recibirLlegada(siguienteCliente(i));
+                });
+            }
+            for (thread& h : terminales) h.join();
+            fila.cerrarLlegadas();
+        });
+        fila.atenderClientes(opciones.cajas);
+        entrada.join();
+        segundos = chrono::steady_clock::now() - inicio;
     }
 
-    carrito.push(prod);       // Si no escribió "BORRAR", agregar normalmente
+    long long recaudo = 0;      // se cuentan las facturas sumando lo cobrado
+    size_t facturas = 0;
+    resumirFacturas(facturas, recaudo);
+
+    cout << "\n" << ANS_BOLD << ANS_BLUE << "RESUMEN HEADLESS\n" << ANS_RESET;
+    cout << "Clientes atendidos: " << opciones.clientes + restaurados << "\n";
+    cout << "Cajas: " << opciones.cajas << "\n";
+    if (opciones.terminales > 0) cout << "Terminales de entrada: " << opciones.terminales << "\n";
+    cout << "Facturas generadas: " << facturas << "\n";
+    cout << "Total recaudado: $" << recaudo << "\n";
+    if (!opciones.rutaDiario.empty())
+        cout << "Diario: " << opciones.rutaDiario << " (" << escritorFacturas.facturasSincronas() << " escritas por las cajas, "
+             << escritorFacturas.facturasDescartadas() << " descartadas)\n";
+    if (!opciones.rutaPuntoControl.empty())
+        cout << "Puntos de control: " << fila.getPuntosGuardados() << " en " << opciones.rutaPuntoControl << " (el último con "
+             << fila.getUltimoPuntoClientes() << " clientes y " << fila.getUltimoPuntoFacturas()
+             << " facturas, " << fila.getUltimoPuntoFacturasNuevas() << " nuevas; pausa máxima de las cajas " << fila.getPausaMaximaNs() / 1e6 << " ms)\n";
+    cout << "Tiempo de atención: " << segundos.count() << " s\n";
+    cout << ANS_GREEN << "Rendimiento: " << (segundos.count() > 0 ? (opciones.clientes + restaurados) / segundos.count() : 0.0)
+         << " clientes/s" << ANS_RESET << "\n";
+    return 0;
 }
 
-    auto [dis, ad, emb] = askPriorityFlags();       //Guarda los valores de la tupla en 3 variables (dis, ad, emb)
-    Cliente c(nombre, carrito, dis, ad, emb, ordenIdx);
-    return c;       //Devuelve el cliente creado
+/**
+ * @brief Lo que se junta de las tiendas al final: cada hilo acumula las suyas y los hilos se combinan en arbol
+ * 
+ */
+struct ResumenTiendas {
+    size_t tiendas = 0;
+    size_t facturas = 0;
+    long long recaudo = 0;
+    LatenciasPorNivel latencias;
+
+    void combinar(const ResumenTiendas& otro) {
+        tiendas += otro.tiendas;
+        facturas += otro.facturas;
+        recaudo += otro.recaudo;
+        latencias.combinar(otro.latencias);
+    }
+};
+
+/**
+ * @brief Fija el hilo actual a uno de los nucleos que el proceso puede usar, para que la memoria de sus tiendas quede
+ * cerca (solo Linux)
+ * 
+ * @param indice Numero del hilo: se usa el nucleo permitido numero indice (dando la vuelta si hay mas hilos que nucleos)
+ * @return true Si se pudo fijar
+ */
+bool fijarNucleo(size_t indice) {
+#ifdef __linux__
+    cpu_set_t permitidos;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(permitidos), &permitidos) != 0) return false;
+    int cantidad = CPU_COUNT(&permitidos);
+    if (cantidad == 0) return false;
+    int buscado = static_cast<int>(indice % static_cast<size_t>(cantidad));
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &permitidos) || buscado-- > 0) continue;
+        cpu_set_t conjunto;
+        CPU_ZERO(&conjunto);
+        CPU_SET(cpu, &conjunto);
+        return pthread_setaffinity_np(pthread_self(), sizeof(conjunto), &conjunto) == 0;
+    }
+    return false;
+#else
+    (void)indice;
+    return false;
+#endif
 }
 
+/**
+ * @brief Modo de varias tiendas: cada hilo toma tiendas de un contador atomico y atiende cada una completa (su fila, sus
+ * cajas, sus facturas y sus precios) sin tocar nada de las demas. Al terminar, los resumenes de los hilos se combinan en
+ * arbol dentro de los mismos hilos: el hilo k espera al k + 1, luego al k + 2, al k + 4... y el hilo 0 queda con el total
+ * 
+ * @return int 0
+ */
+int ejecutarTiendas() {
+    // malloc ya tiene memoria separada por hilo. Con --arena cada tienda tiene la suya como recurso de su hilo (y de sus
+    // cajas), no como recurso por defecto del proceso: asi ninguna tienda comparte recurso con otra
+    ArenaCorrida::Tipo tipo = opciones.arena.empty() ? ArenaCorrida::Tipo::Ninguna : tipoArena();
+    TrazaLlegadas traza;
+    if (!opciones.rutaTraza.empty()) {      // todas las tiendas reproducen la misma traza
+        string error;
+        if (!traza.cargar(opciones.rutaTraza, error)) {
+            cerr << ANS_RED << error << ANS_RESET << "\n";
+            return 1;
+        }
+        opciones.clientes = traza.size();
+    }
+    bool usarTraza = !opciones.rutaTraza.empty();
+    auto clienteDeTienda = [&traza, usarTraza](uint64_t tienda, size_t i) {
+        if (usarTraza) return traza.cliente(i);
+        return opciones.generar ? generadorCarga.cliente(tienda * opciones.clientes + i) : crearClienteDemo(i);
+    };
+
+    size_t numHilos = opciones.hilos > 0 ? static_cast<size_t>(opciones.hilos) : max<size_t>(1, thread::hardware_concurrency());
+    numHilos = min(numHilos, opciones.tiendas);
+    vector<ResumenTiendas> parciales(numHilos);
+    unique_ptr<atomic<bool>[]> listos(new atomic<bool>[numHilos]);
+    for (size_t k = 0; k < numHilos; ++k) listos[k].store(false);
+    atomic<size_t> siguienteTienda{0};
+    atomic<size_t> sinAfinidad{0};
+
+    auto trabajar = [&](size_t k) {
+        if (opciones.afinidad && !fijarNucleo(k)) ++sinAfinidad;
+        ResumenTiendas& propio = parciales[k];
+        for (size_t t = siguienteTienda++; t < opciones.tiendas; t = siguienteTienda++) {
+            ArenaCorrida arena(tipo, opciones.cajas > 1, true);       // primero: se destruye despues de la fila y las facturas
+            Tienda tienda;
+            tienda.numero = t;
+            tiendaDelHilo = &tienda;
+            {
+                ColaPrioritariaD1<> fila;
+                fila.fijarEnvejecimiento(static_cast<int64_t>(opciones.envejecimiento * 1e9));
+                for (size_t i = 0; i < opciones.clientes; ++i) fila.agregarCliente(clienteDeTienda(t, i));
+                fila.atenderClientes(opciones.cajas, &propio.latencias);
+            }
+            tiendaDelHilo = nullptr;
+            ++propio.tiendas;
+            propio.facturas += tienda.facturas.size();
+            while (!tienda.facturas.empty()) {
+                propio.recaudo += tienda.facturas.front().total;
+                tienda.facturas.pop();
+            }
+        }
+        for (size_t paso = 1; k % (2 * paso) == 0 && k + paso < numHilos; paso *= 2) {     // reduccion en arbol
+            while (!listos[k + paso].load(memory_order_acquire)) this_thread::yield();
+            propio.combinar(parciales[k + paso]);
+        }
+        listos[k].store(true, memory_order_release);
+    };
+
+    auto inicio = chrono::steady_clock::now();
+    vector<thread> hilos;
+    for (size_t k = 1; k < numHilos; ++k) hilos.emplace_back(trabajar, k);
+    trabajar(0);
+    for (thread& h : hilos) h.join();
+    chrono::duration<double> segundos = chrono::steady_clock::now() - inicio;
+
+    const ResumenTiendas& total = parciales[0];
+    size_t clientes = opciones.tiendas * opciones.clientes;
+    cout << "\n" << ANS_BOLD << ANS_BLUE << "RESUMEN DE TIENDAS\n" << ANS_RESET;
+    cout << "Tiendas: " << total.tiendas << " (" << opciones.clientes << " clientes y " << opciones.cajas << " cajas cada una)\n";
+    cout << "Hilos: " << numHilos;
+    if (opciones.afinidad) cout << (sinAfinidad.load() == 0 ? " fijados a un núcleo cada uno" : " (no se pudo fijar la afinidad)");
+    cout << "\n";
+    cout << "Facturas generadas: " << total.facturas << "\n";
+    cout << "Total recaudado: $" << total.recaudo << "\n";
+    total.latencias.mostrar(1e6, "ms");
+    cout << "Tiempo de atención: " << segundos.count() << " s\n";
+    cout << ANS_GREEN << "Rendimiento: " << (segundos.count() > 0 ? clientes / segundos.count() : 0.0)
+         << " clientes/s" << ANS_RESET << "\n";
+    return 0;
+}
 
+#ifndef D1_SIN_MAIN       // D1benchmark.cpp incluye este archivo y define su propio main
 /**
  * @brief Funcion MAIN que habilita las pantallas y procesos
  * 
  * @return int 0
  */
-int main() {
+int main(int argc, char* argv[]) {
     enableVirtualTerminalProcessingOnWindows();       //Habilita que los codigos ANSI funcionen correctamente
 
-    srand(static_cast<unsigned>(time(0)));        //Inicializa el gnerador de numeros aleatorios con la hora actual
+    if (!leerOpciones(argc, argv)) {        //Opciones invalidas: se muestra la ayuda
+        mostrarAyuda(argv[0]);
+        return 1;
+    }
+    if (opciones.ayuda) {
+        mostrarAyuda(argv[0]);
+        return 0;
+    }
+
+    motorPrecios.fijarSemilla(opciones.semilla != 0 ? opciones.semilla
+                              : (static_cast<uint64_t>(random_device{}()) << 32) ^ static_cast<uint64_t>(time(0)));
+    if (!opciones.rutaPrecios.empty()) {        // tabla de precios fijos
+        string error;
+        if (!motorPrecios.cargarCsv(opciones.rutaPrecios, error)) {
+            cerr << ANS_RED << error << ANS_RESET << "\n";
+            return 1;
+        }
+    }
+
+    if (opciones.generar || opciones.simular || !opciones.rutaGenerarTraza.empty()) {      // carga sintetica
+        string error;
+        if (!generadorCarga.leerPerfil(opciones.perfilCarga, error)) {
+            cerr << ANS_RED << error << ANS_RESET << "\n";
+            return 1;
+        }
+        generadorCarga.preparar(motorPrecios.getSemilla());
+        if (!opciones.rutaGenerarTraza.empty()) {
+            auto inicio = chrono::steady_clock::now();
+            if (!generadorCarga.escribirTraza(opciones.rutaGenerarTraza, opciones.clientes, error)) {
+                cerr << ANS_RED << error << ANS_RESET << "\n";
+                return 1;
+            }
+            chrono::duration<double> segundos = chrono::steady_clock::now() - inicio;
+            cout << "Traza " << opciones.rutaGenerarTraza << ": " << opciones.clientes << " clientes en " << segundos.count() << " s\n";
+            return 0;
+        }
+    }
+
+    string tipoSalida = opciones.salida;
+    if (tipoSalida.empty()) tipoSalida = !opciones.headless ? "terminal" : opciones.tiendas > 1 ? "nula" : "buffer";
+    if (tipoSalida == "buffer") salidaGlobal.reset(new SalidaBuffer());
+    else if (tipoSalida == "nula") salidaGlobal.reset(new SalidaNula());
+
+    if (!opciones.rutaAnalisis.empty()) return analizarDiario(opciones.rutaAnalisis);       //Solo se analiza un diario existente
+    if (!opciones.rutaDiario.empty()) {
+        string error;
+        if (!diarioFacturas.abrir(opciones.rutaDiario, error)) {
+            cerr << ANS_RED << error << ANS_RESET << "\n";
+            return 1;
+        }
+        EscritorAsincrono::Contrapresion politica = EscritorAsincrono::Contrapresion::Esperar;
+        if (opciones.contrapresion == "descartar") politica = EscritorAsincrono::Contrapresion::Descartar;
+        else if (opciones.contrapresion == "sincrono") politica = EscritorAsincrono::Contrapresion::Sincrono;
+        escritorFacturas.iniciar(diarioFacturas, politica, opciones.capacidadEscritor);
+    }
 
-    ColaPrioritariaD1 fila;       //Crea la cola con prioridad que guarda los clientes del supermercado
+    if (opciones.simular) return ejecutarSimulacion();      //Tiempo virtual: no se cobra ni se espera
+    if (opciones.tiendas > 1) return ejecutarTiendas();     //Varias tiendas en paralelo, sin nada compartido
+    if (opciones.headless) return ejecutarHeadless();       //Modo por lotes: no hay pantallas ni preguntas
+
+    ColaPrioritariaD1<> fila;       //Crea la cola con prioridad que guarda los clientes del supermercado
+    fila.fijarEnvejecimiento(static_cast<int64_t>(opciones.envejecimiento * 1e9));
 
     pantallaInicio();       //Muestra la escena inicial y pide al usuario que modo usar (crear clientes o no)
 
@@ -606,44 +3393,8 @@ int main() {
      */
     bool modoPrueba = (choice == "S");
     if (modoPrueba) {
-        // Cliente Sofía (discapacidad)
-        CarritoDeCompras carritoSofia("Sofía");
-        carritoSofia.push("Huevos");
-        carritoSofia.push("Leche");
-        carritoSofia.push("Pan");
-        fila.agregarCliente("Sofía", carritoSofia, true, false, false);
-
-        // Cliente Carlos (adulto mayor)
-        CarritoDeCompras carritoCarlos("Carlos");
-        carritoCarlos.push("Café");
-        carritoCarlos.push("Queso");
-        carritoCarlos.push("Pan integral");
-        fila.agregarCliente("Carlos", carritoCarlos, false, true, false);
-
-        // Cliente Marta (embarazada)
-        CarritoDeCompras carritoMarta("Marta");
-        carritoMarta.push("Yogurt");
-        carritoMarta.push("Manzanas");
-        carritoMarta.push("Galletas");
-        carritoMarta.push("Agua");
-        fila.agregarCliente("Marta", carritoMarta, false, false, true);
-
-        // Cliente Ana (pocos productos)
-        CarritoDeCompras carritoAna("Ana");
-        carritoAna.push("Leche");
-        carritoAna.push("Pan");
-        carritoAna.push("Huevos");
-        fila.agregarCliente("Ana", carritoAna, false, false, false);
-
-        // Cliente Luis (carro grande)
-        CarritoDeCompras carritoLuis("Luis");
-        carritoLuis.push("Arroz");
-        carritoLuis.push("Aceite");
-        carritoLuis.push("Azúcar");
-        carritoLuis.push("Lentejas");
-        carritoLuis.push("Cereal");
-        carritoLuis.push("Papel higiénico");
-        fila.agregarCliente("Luis", carritoLuis, false, false, false);
+        for (size_t i = 0; i < CLIENTES_DEMO; ++i)      // Sofía, Carlos, Marta, Ana y Luis
+            agregarClienteDemo(fila, i);
     } else {
 
         /**
@@ -655,7 +3406,7 @@ int main() {
 
         int orden = 0;
         while (true) {
-            cout << ANS_BOLD << "¿Deseas agregar un cliente? (S/N): " << ANS_RESET;
+            cout << ANS_BOLD << "¿Deseas agregar un cliente? (S/N, o I para importar un CSV/JSON): " << ANS_RESET;
             string resp;
             getline(cin, resp);
             if (resp.empty()) continue;
@@ -663,15 +3414,27 @@ int main() {
             if (c == 'N') break;
             if (c == 'S') {
                 Cliente nuevo = buildClientInteractive(orden++);        //Se crea un nuevo cliente
-                fila.agregarCliente(nuevo.nombre, nuevo.carrito, nuevo.discapacidad, nuevo.adultoMayor, nuevo.embarazada);        //Se agrega el cliente a la cola
+                fila.agregarCliente(move(nuevo));        //Se agrega el cliente a la cola
+            } else if (c == 'I') {
+                string ruta = askLine("Archivo de clientes (CSV o JSON): ");      //Importa muchos clientes de una vez
+                ImportacionClientes importacion;
+                string error;
+                if (importacion.cargar(ruta, error)) {
+                    size_t importados = importacion.size();
+                    fila.agregarClientes(importacion.clientes());
+                    cout << ANS_GREEN << importados << " clientes importados de " << ruta << ANS_RESET << "\n";
+                } else {
+                    cout << ANS_RED << error << ANS_RESET << "\n";
+                }
             } else {
-                cout << ANS_RED << "Respuesta inválida. Por favor S o N.\n" << ANS_RESET;
+                cout << ANS_RED << "Respuesta inválida. Por favor S, N o I.\n" << ANS_RESET;
             }
         }
     }
 
     if (fila.empty()) {       //Si no hay clientes, el programa se cierra
         cout << ANS_RED << "No hay clientes para procesar. Finalizando programa.\n" << ANS_RESET;
+        terminarFacturacion();
         pantallaFinal();
         return 0;
     }
@@ -692,28 +3455,13 @@ int main() {
      * @brief Atender clientes (usa la lógica original)
      * 
      */
-    fila.atenderClientes();
+    fila.atenderClientes(opciones.cajas);
 
     /**
      * @brief Mostrar facturas generadas (historial de atención)
      * 
      */
-    cout << "\n" << ANS_BOLD << ANS_BLUE << "FACTURAS GENERADAS:\n" << ANS_RESET;
-    int contador = 1;
-    while (!colaFacturas.empty()) { // mientras la cola no este vacia
-        Factura f = colaFacturas.front(); // obtiene el primer puesto
-        colaFacturas.pop(); // elimina el primer puesto
-
-        cout << ANS_YELLOW << "Factura #" << contador++ << ANS_RESET << "\n";
-        cout << "Cliente: " << f.nombreCliente << "\n";
-        cout << "Fecha y hora: " << f.fechaHora << "\n";
-        cout << "Productos:\n";
-        for (auto &p : f.productos) {
-        cout << "  - " << p.first << ": $" << p.second << "\n";
-        }
-        cout << ANS_GREEN << "Total: $" << f.total << ANS_RESET << "\n";
-        cout << "----------------------------------------\n";
-    }
+    imprimirFacturas();
 
     /**
      * @brief Construcye una nueva pantalla Final
@@ -722,4 +3470,5 @@ int main() {
     pantallaFinal();
 
     return 0;
-}
\ No newline at end of file
+}
+#endif
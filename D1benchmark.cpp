@@ -0,0 +1,460 @@
+/**
+ * @file D1benchmark.cpp
+ * @author Juan Bohorquez (jbohorquezsa@unal.edu.co)
+ * @author Julian Quintero (julquinteroca@unal.edu.co)
+ * @author Santiago Herrera (sanherrerapa@unal.edu.co)
+ *
+ * @brief Microbenchmarks del D1: carritos, fila con prioridad, comparador, cobro y facturas. Cada medicion reporta
+ * ns/op, asignaciones/op y bytes/op, en tabla, JSON o CSV para comparar corridas entre versiones.
+ * Reutiliza las clases de D1actualizado1.cpp sin su main.
+ * Compilar con: g++ -std=c++17 -O2 -pthread D1benchmark.cpp -o D1benchmark
+ * Uso: D1benchmark [--clientes N] [--formato tabla|json|csv] [--filtro TEXTO]
+ * @version 0.2
+ * @date 2025-10-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"     // falso positivo: new y delete se reemplazan juntos sobre malloc/free
+#endif
+#define D1_SIN_MAIN
+#include "D1actualizado1.cpp"
+
+#include <new>       // Reemplazo de operator new para contar asignaciones
+
+/**
+ * @brief Contadores globales de asignaciones de memoria (todo new del programa pasa por aqui)
+ *
+ */
+atomic<size_t> asignaciones{0};
+atomic<size_t> bytesAsignados{0};
+
+void* operator new(size_t n) {
+    asignaciones.fetch_add(1, memory_order_relaxed);
+    bytesAsignados.fetch_add(n, memory_order_relaxed);
+    if (void* p = malloc(n ? n : 1)) return p;
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+void* operator new(size_t n, align_val_t alineacion) {        // la usan los recursos pmr (new_delete_resource)
+    asignaciones.fetch_add(1, memory_order_relaxed);
+    bytesAsignados.fetch_add(n, memory_order_relaxed);
+    size_t a = static_cast<size_t>(alineacion);
+    if (void* p = aligned_alloc(a, (max<size_t>(n, 1) + a - 1) / a * a)) return p;
+    throw bad_alloc();
+}
+
+void operator delete(void* p, align_val_t) noexcept { free(p); }
+void operator delete(void* p, size_t, align_val_t) noexcept { free(p); }
+
+/**
+ * @brief Impide que el compilador elimine un calculo cuyo resultado no se usa
+ *
+ */
+template <class T>
+inline void noOptimizar(const T& valor) {
+    asm volatile("" : : "r,m"(valor) : "memory");
+}
+
+/**
+ * @brief Resultado de una medicion
+ *
+ */
+struct Resultado {
+    string grupo;       // que se mide (carrito_push, cola_pop, ...)
+    string parametro;   // tamaño o mezcla medida
+    size_t operaciones = 0;
+    double nsPorOp = 0;
+    double asignacionesPorOp = 0;
+    double bytesPorOp = 0;
+};
+
+vector<Resultado> resultados;
+string filtro;      // solo se corren los grupos que contienen este texto
+
+/**
+ * @brief Mide un bloque de trabajo. preparar corre fuera del tiempo; cuerpo hace "operaciones" operaciones
+ *
+ * @param grupo Nombre del grupo
+ * @param parametro Tamaño o mezcla
+ * @param operaciones Operaciones que hace cuerpo (para dividir)
+ * @param preparar Trabajo previo que no se mide
+ * @param cuerpo Trabajo medido
+ */
+template <class Preparar, class Cuerpo>
+void medir(const string& grupo, const string& parametro, size_t operaciones, Preparar preparar, Cuerpo cuerpo) {
+    if (!filtro.empty() && grupo.find(filtro) == string::npos) return;
+    preparar();
+    size_t asignAntes = asignaciones.load(), bytesAntes = bytesAsignados.load();
+    auto t0 = chrono::steady_clock::now();
+    cuerpo();
+    auto t1 = chrono::steady_clock::now();
+    Resultado r;
+    r.grupo = grupo;
+    r.parametro = parametro;
+    r.operaciones = operaciones;
+    r.nsPorOp = chrono::duration<double, nano>(t1 - t0).count() / operaciones;
+    r.asignacionesPorOp = static_cast<double>(asignaciones.load() - asignAntes) / operaciones;
+    r.bytesPorOp = static_cast<double>(bytesAsignados.load() - bytesAntes) / operaciones;
+    resultados.push_back(r);
+}
+
+/**
+ * @brief Arma clientes de plantilla con la fraccion pedida de atencion especial y carritos de ambos lados del limite de 5
+ *
+ * @param fraccionEspecial Fraccion de clientes con atencion especial (0 a 1)
+ * @return vector<Cliente> Plantillas que se copian en cada llegada
+ */
+vector<Cliente> crearPlantillas(double fraccionEspecial) {
+    vector<Cliente> plantillas;
+    GeneradorXoshiro gen(42);
+    for (int i = 0; i < 64; ++i) {
+        string nombre = "Cliente " + to_string(i);
+        CarritoDeCompras carrito(nombre);
+        int productos = 1 + (i * 7) % 9;        // entre 1 y 9 productos
+        for (int p = 0; p < productos; ++p) carrito.push("Producto " + to_string(p));
+        bool especial = gen.uniforme() < fraccionEspecial;
+        plantillas.emplace_back(nombre, carrito, especial && i % 3 == 0, especial && i % 3 == 1, especial && i % 3 == 2, 0);
+    }
+    return plantillas;
+}
+
+/**
+ * @brief Meter y sacar n clientes de una cola, devolviendo el orden en que fueron atendidos
+ *
+ * @tparam Cola priority_queue, ColaPorNiveles o HeapIndexado
+ */
+template <class Cola>
+void medirCola(const string& nombre, const string& mezcla, const vector<Cliente>& plantillas, size_t n, vector<int>& atendidos) {
+    Cola cola;
+    vector<Cliente> llegadas;
+    medir(nombre + "_push", mezcla, n, [&]() {
+        llegadas.clear();
+        llegadas.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            llegadas.push_back(plantillas[i % plantillas.size()]);
+            llegadas.back().ordenLlegada = static_cast<int>(i);
+        }
+    }, [&]() {
+        for (Cliente& c : llegadas) cola.push(move(c));
+    });
+    atendidos.clear();
+    atendidos.reserve(n);
+    medir(nombre + "_pop", mezcla, n, []() {}, [&]() {
+        while (!cola.empty()) {
+            atendidos.push_back(cola.top().ordenLlegada);
+            cola.pop();
+        }
+    });
+}
+
+/**
+ * @brief Mediciones del carrito: push, pop, mostrarProductos y getProductos para varios tamaños
+ *
+ */
+void medirCarritos() {
+    const size_t REPETICIONES = 20000;
+    for (int tam : {1, 4, 16, 64}) {
+        string parametro = to_string(tam) + " productos";
+        vector<IdProducto> ids;
+        for (int p = 0; p < tam; ++p) ids.push_back(catalogo().registrar("Producto " + to_string(p)));
+        vector<CarritoDeCompras> carritos;
+
+        medir("carrito_push", parametro, REPETICIONES * tam, [&]() {
+            carritos.assign(REPETICIONES, CarritoDeCompras("Cliente"));
+        }, [&]() {
+            for (CarritoDeCompras& c : carritos)
+                for (IdProducto id : ids) c.push(id);
+        });
+
+        SalidaMemoria texto;
+        medir("carrito_mostrarProductos", parametro, REPETICIONES, []() {}, [&]() {
+            for (const CarritoDeCompras& c : carritos) {
+                texto.limpiar();
+                c.mostrarProductos(texto);
+            }
+            noOptimizar(texto.contenido().size());
+        });
+
+        medir("carrito_getProductos", parametro, REPETICIONES, []() {}, [&]() {
+            for (const CarritoDeCompras& c : carritos) {
+                PilaProductos copia = c.getProductos();     // copia: lo que hace quien necesita desarmarla
+                noOptimizar(copia.size());
+            }
+        });
+
+        medir("carrito_pop", parametro, REPETICIONES * tam, []() {}, [&]() {
+            for (CarritoDeCompras& c : carritos)
+                while (!c.empty()) c.pop();
+        });
+    }
+}
+
+/**
+ * @brief Mediciones de la fila: push/pop con distintas mezclas de prioridad y costo del comparador
+ *
+ * @param n Clientes por medicion
+ * @return true Si la cola por niveles atendio en el mismo orden que el heap en todas las mezclas
+ */
+bool medirFila(size_t n) {
+    bool mismoOrden = true;
+    for (double fraccion : {0.0, 0.1, 0.5, 1.0}) {
+        string mezcla = to_string(static_cast<int>(fraccion * 100)) + "% especiales";
+        vector<Cliente> plantillas = crearPlantillas(fraccion);
+        vector<int> ordenHeap, ordenNiveles, ordenIndexado;
+        medirCola<priority_queue<Cliente, vector<Cliente>, ComparadorPrioridad<>>>("heap", mezcla, plantillas, n, ordenHeap);
+        medirCola<ColaPorNiveles<>>("niveles", mezcla, plantillas, n, ordenNiveles);
+        medirCola<HeapIndexado<>>("indexado", mezcla, plantillas, n, ordenIndexado);
+        if (!ordenHeap.empty() && !ordenNiveles.empty() && ordenHeap != ordenNiveles) mismoOrden = false;
+        if (!ordenHeap.empty() && !ordenIndexado.empty() && ordenHeap != ordenIndexado) mismoOrden = false;
+
+        ComparadorPrioridad<> comparar;
+        const size_t COMPARACIONES = 1 << 22;
+        medir("comparador", mezcla, COMPARACIONES, []() {}, [&]() {
+            size_t menores = 0;
+            for (size_t i = 0; i < COMPARACIONES; ++i)
+                menores += comparar(plantillas[i & 63], plantillas[(i * 7 + 3) & 63]);
+            noOptimizar(menores);
+        });
+    }
+    return mismoOrden;
+}
+
+/**
+ * @brief Abandonos y cambios de carrito en el heap indexado: con n clientes esperando se saca uno de cada dos por su
+ * manejador, y a la otra mitad se le agrega un producto (los de 4 pasan de carrito pequeño a grande) y se reordena
+ *
+ * @param n Clientes en la fila
+ * @return true Si despues de los cambios la cola sigue atendiendo en el orden de ComparadorPrioridad
+ */
+bool medirIndexado(size_t n) {
+    vector<Cliente> plantillas = crearPlantillas(0.1);
+    HeapIndexado<> cola;
+    vector<ManejadorCliente> manejadores;
+    auto llenar = [&]() {
+        cola = HeapIndexado<>();
+        manejadores.clear();
+        for (size_t i = 0; i < n; ++i) {
+            Cliente c = plantillas[i % plantillas.size()];
+            c.ordenLlegada = static_cast<int>(i);
+            manejadores.push_back(cola.push(move(c)));
+        }
+    };
+    size_t mitad = n / 2;
+    medir("indexado_remove", "10% especiales", mitad, llenar, [&]() {
+        for (size_t i = 0; i < n; i += 2) cola.remove(manejadores[i]);
+    });
+    medir("indexado_update", "10% especiales", mitad, llenar, [&]() {
+        for (size_t i = 1; i < n; i += 2) {
+            cola.buscar(manejadores[i])->carrito.push(IdProducto(0));
+            cola.update(manejadores[i]);
+        }
+    });
+    bool ordenado = true;       // lo que queda debe salir en el orden de ComparadorPrioridad
+    ComparadorPrioridad<> comparar;
+    Cliente anterior;
+    for (bool primero = true; !cola.empty(); primero = false) {
+        Cliente c = move(cola.top());
+        cola.pop();
+        if (!primero && comparar(anterior, c)) ordenado = false;
+        anterior = move(c);
+    }
+    return ordenado;
+}
+
+/**
+ * @brief Nivel escrito a mano con las constantes fijas, para comparar con PoliticaD1
+ *
+ * @tparam LIMITE Limite de la caja rapida
+ */
+template <size_t LIMITE>
+inline int nivelAMano(const Cliente& c) {
+    if (c.discapacidad || c.adultoMayor || c.embarazada) return 3;
+    if (c.carrito.size() < LIMITE) return 2;
+    return 1;
+}
+
+/**
+ * @brief Suma los niveles de muchas consultas sobre las plantillas; el resultado se compara entre versiones
+ *
+ * @param nivel Funcion Cliente -> nivel
+ */
+template <class Nivel>
+size_t medirNivel(const string& parametro, const vector<Cliente>& plantillas, Nivel nivel) {
+    const size_t CONSULTAS = 1 << 22;
+    size_t suma = 0;
+    medir("politica_nivel", parametro, CONSULTAS, []() {}, [&]() {
+        for (size_t i = 0; i < CONSULTAS; ++i) suma += static_cast<size_t>(nivel(plantillas[(i * 7) & 63]));
+        noOptimizar(suma);
+    });
+    return suma;
+}
+
+/**
+ * @brief Meter n clientes en una ColaPrioritariaD1 y sacarlos con sacarSiguiente, con cada almacen
+ *
+ * @tparam Fila ColaPrioritariaD1 con su politica y su almacen
+ */
+template <class Fila>
+void medirFilaD1(const string& almacen, const vector<Cliente>& plantillas, size_t n) {
+    Fila fila;
+    medir("filaD1_agregar_sacar", almacen, n, []() {}, [&]() {
+        for (size_t i = 0; i < n; ++i) fila.agregarCliente(plantillas[i % plantillas.size()], 0);
+        Cliente c;
+        while (fila.sacarSiguiente(c)) noOptimizar(c.ordenLlegada);
+    });
+}
+
+/**
+ * @brief Politicas de prioridad en plantilla contra el mismo codigo escrito a mano, y la fila completa con cada almacen
+ *
+ * @param n Clientes en la fila
+ * @return true Si cada politica dio los mismos niveles que su version a mano
+ */
+bool medirPoliticas(size_t n) {
+    vector<Cliente> plantillas = crearPlantillas(0.1);
+    bool iguales = true;
+    size_t porDefecto = medirNivel("PoliticaD1<>", plantillas, [](const Cliente& c) { return PoliticaPorDefecto::nivel(c); });
+    size_t aMano = medirNivel("a mano (5)", plantillas, [](const Cliente& c) { return nivelAMano<5>(c); });
+    size_t express = medirNivel("PoliticaD1<8>", plantillas, [](const Cliente& c) { return PoliticaD1<8>::nivel(c); });
+    size_t aMano8 = medirNivel("a mano (8)", plantillas, [](const Cliente& c) { return nivelAMano<8>(c); });
+    if (porDefecto != aMano || express != aMano8) iguales = false;
+
+    medirFilaD1<ColaPrioritariaD1<>>("niveles", plantillas, n);
+    medirFilaD1<ColaPrioritariaD1<PoliticaPorDefecto, HeapIndexado>>("indexado", plantillas, n);
+    medirFilaD1<ColaPrioritariaD1<PoliticaD1<8>>>("niveles, express 8", plantillas, n);
+    return iguales;
+}
+
+/**
+ * @brief Costo por producto de procesarCarrito y de vaciar la cola de facturas, con el heap normal y con la arena pool
+ *
+ */
+void medirCobro() {
+    const size_t CARRITOS = 20000;
+    for (auto [tipo, nombreArena] : {pair<ArenaCorrida::Tipo, string>{ArenaCorrida::Tipo::Ninguna, "heap"},
+                                     pair<ArenaCorrida::Tipo, string>{ArenaCorrida::Tipo::Pool, "pool"}})
+    for (int tam : {1, 8, 64}) {
+        ArenaCorrida arena(tipo, false);        // primero: se destruye despues de carritos y facturas
+        string parametro = to_string(tam) + " productos " + nombreArena;
+        vector<IdProducto> ids;
+        for (int p = 0; p < tam; ++p) ids.push_back(catalogo().registrar("Producto con nombre largo " + to_string(p)));
+        vector<PilaProductos> carritos;
+        medir("procesarCarrito_por_producto", parametro, CARRITOS * tam, [&]() {
+            carritos.clear();
+            for (size_t i = 0; i < CARRITOS; ++i) carritos.emplace_back(ids.begin(), ids.end());
+        }, [&]() {
+            for (size_t i = 0; i < CARRITOS; ++i) procesarCarrito("Cliente", carritos[i].vista(), static_cast<int>(i));
+        });
+
+        size_t facturas = 0;
+        long long recaudo = 0;
+        medir("facturas_drenar", parametro, CARRITOS, [&]() {
+            resumirFacturas(facturas, recaudo);     // lo que dejo procesarCarrito (o nada, si se filtro)
+            ProductosFactura productos;
+            for (IdProducto id : ids) productos.emplace_back(id, 1000);
+            for (size_t i = 0; i < CARRITOS; ++i) colaFacturas.emplace_back("Cliente", productos, 1000 * tam, instanteActualNs());
+        }, [&]() {
+            resumirFacturas(facturas, recaudo);
+            noOptimizar(recaudo);
+        });
+        carritos.clear();
+        resumirFacturas(facturas, recaudo);     // nada reservado en la arena puede sobrevivirla
+    }
+}
+
+/**
+ * @brief Costo de registrar un tiempo en el histograma de latencias (debe ser de pocos ns para dejarlo siempre activo)
+ *
+ */
+void medirHistograma() {
+    const size_t REGISTROS = 1 << 24;
+    HistogramaHdr h;
+    medir("histograma_registrar", "1..2^40 ns", REGISTROS, []() {}, [&]() {
+        GeneradorXoshiro gen(7);
+        for (size_t i = 0; i < REGISTROS; ++i) h.registrar(static_cast<int64_t>(gen.siguiente() >> 24));
+        noOptimizar(h.cantidad());
+    });
+    medir("histograma_percentil", "p99.9", 1000, []() {}, [&]() {
+        int64_t suma = 0;
+        for (int i = 0; i < 1000; ++i) suma += h.percentil(99.9);
+        noOptimizar(suma);
+    });
+}
+
+/**
+ * @brief Imprime los resultados en el formato pedido
+ *
+ * @param formato tabla, json o csv
+ */
+void reportar(const string& formato) {
+    if (formato == "json") {
+        cout << "[\n";
+        for (size_t i = 0; i < resultados.size(); ++i) {
+            const Resultado& r = resultados[i];
+            cout << "  {\"grupo\": \"" << r.grupo << "\", \"parametro\": \"" << r.parametro << "\", \"operaciones\": "
+                 << r.operaciones << ", \"ns_op\": " << r.nsPorOp << ", \"asignaciones_op\": " << r.asignacionesPorOp
+                 << ", \"bytes_op\": " << r.bytesPorOp << "}" << (i + 1 < resultados.size() ? "," : "") << "\n";
+        }
+        cout << "]\n";
+    } else if (formato == "csv") {
+        cout << "grupo,parametro,operaciones,ns_op,asignaciones_op,bytes_op\n";
+        for (const Resultado& r : resultados)
+            cout << r.grupo << "," << r.parametro << "," << r.operaciones << "," << r.nsPorOp << ","
+                 << r.asignacionesPorOp << "," << r.bytesPorOp << "\n";
+    } else {
+        printf("%-30s %-18s %12s %10s %10s %10s\n", "grupo", "parametro", "ops", "ns/op", "asig/op", "bytes/op");
+        for (const Resultado& r : resultados)
+            printf("%-30s %-18s %12zu %10.2f %10.3f %10.1f\n", r.grupo.c_str(), r.parametro.c_str(), r.operaciones,
+                   r.nsPorOp, r.asignacionesPorOp, r.bytesPorOp);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    opciones.headless = true;       // sin pausas de presentacion
+    salidaGlobal.reset(new SalidaNula());       // los carritos y las cajas no imprimen: solo se mide la logica
+    motorPrecios.fijarSemilla(1);
+
+    size_t n = 1000000;       // 10^6 clientes por defecto en la fila
+    string formato = "tabla";
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--clientes" && i + 1 < argc) n = static_cast<size_t>(stoll(argv[++i]));
+        else if (arg == "--formato" && i + 1 < argc) formato = argv[++i];
+        else if (arg == "--filtro" && i + 1 < argc) filtro = argv[++i];
+        else {
+            cerr << "Uso: " << argv[0] << " [--clientes N] [--formato tabla|json|csv] [--filtro TEXTO]\n";
+            return 1;
+        }
+    }
+    if (formato != "tabla" && formato != "json" && formato != "csv") {
+        cerr << "Formato inválido: " << formato << "\n";
+        return 1;
+    }
+
+    medirCarritos();
+    bool mismoOrden = medirFila(n);
+    bool indexadoOrdenado = medirIndexado(n);
+    bool politicasIguales = medirPoliticas(n);
+    medirCobro();
+    medirHistograma();
+    reportar(formato);
+
+    if (!mismoOrden) {
+        cerr << ANS_RED << "ERROR: la cola por niveles o el heap indexado atendieron en distinto orden que el heap\n" << ANS_RESET;
+        return 1;
+    }
+    if (!politicasIguales) {
+        cerr << ANS_RED << "ERROR: una politica en plantilla dio otros niveles que su version a mano\n" << ANS_RESET;
+        return 1;
+    }
+    if (!indexadoOrdenado) {
+        cerr << ANS_RED << "ERROR: el heap indexado quedo desordenado despues de update\n" << ANS_RESET;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,795 @@
+/**
+ * @file D1comun.h
+ * @author Juan Bohorquez (jbohorquezsa@unal.edu.co)
+ * @author Julian Quintero (julquinteroca@unal.edu.co)
+ * @author Santiago Herrera (sanherrerapa@unal.edu.co)
+ *
+ * @brief Piezas comunes del D1: colores de la consola, salidas de texto, catalogo de productos, carritos,
+ * clientes, facturas, arenas de memoria y archivos mapeados. No dependen de las opciones ni del main, asi que los demas
+ * encabezados y los programas de pruebas las pueden usar solas
+ * @version 0.2
+ * @date 2025-10-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef D1_COMUN_H
+#define D1_COMUN_H
+
+#include <iostream>  // Salida a la terminal
+#include <string>    // Para usar los string
+#include <vector>    // Permite usar vectores dinamicos
+#include <deque>     // Nombres del catalogo (las referencias no se invalidan al crecer)
+#include <ctime>     // localtime para la fecha de las facturas
+#include <chrono>    // Relojes para medir latencias y fechar las facturas
+#include <mutex>     // Exclusion mutua en las salidas y la arena monotona
+#include <atomic>    // Contadores compartidos entre hilos
+#include <memory>    // unique_ptr para la salida global y los recursos de memoria
+#include <cstdint>   // Enteros de tamaño fijo (identificadores de producto)
+#include <cstdlib>   // malloc y free de la pila compacta
+#include <cstdio>    // snprintf y lectura de archivos en Windows
+#include <cstring>   // memcpy para copiar bloques de productos
+#include <string_view> // Nombres de producto sin copiar al buscarlos en el catalogo
+#include <unordered_map> // Indice nombre -> identificador del catalogo
+#include <shared_mutex>  // Varias lecturas simultaneas del catalogo
+#include <charconv>  // to_chars: enteros a texto sin reservar memoria
+#include <type_traits> // Para elegir como se imprime cada tipo en las salidas
+#include <algorithm> // max y min
+#include <memory_resource>  // Arenas de memoria (pmr) para carritos, clientes y facturas de una corrida
+
+#ifdef _WIN32
+  #include <fstream>   // Lectura completa de archivos, sin mmap
+  #include <iterator>  // istreambuf_iterator
+#else
+  #include <sys/mman.h>  // mmap para leer archivos grandes sin copiarlos
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+/**
+ * @brief Declarar los colores que apareceran en la consola
+ * 
+ */
+inline const std::string ANS_RESET   = "\033[0m";
+inline const std::string ANS_BOLD    = "\033[1m";
+inline const std::string ANS_RED     = "\033[31m";
+inline const std::string ANS_GREEN   = "\033[32m";
+inline const std::string ANS_YELLOW  = "\033[33m";
+inline const std::string ANS_BLUE    = "\033[34m";
+inline const std::string ANS_MAGENTA = "\033[35m";
+inline const std::string ANS_CYAN    = "\033[36m";
+inline const std::string ANS_WHITE   = "\033[37m"; // codigos ansi para color y formato
+
+/**
+ * @brief Instante actual del reloj monotono en nanosegundos, para medir latencias
+ * 
+ * @return int64_t Nanosegundos desde un origen arbitrario
+ */
+inline int64_t ahoraNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Salida de texto de la atencion (carritos, fila, cobro). Hay tres tipos: terminal (cada escritura se muestra de una
+ * vez), buffer (acumula mucho texto y lo escribe en bloques) y nula (descarta todo, para medir solo la logica). Las
+ * escrituras se pueden hacer desde varios hilos
+ * 
+ */
+class SalidaConsola {
+private:
+    bool activa_;
+
+public:
+    explicit SalidaConsola(bool activa = true) : activa_(activa) {}
+    virtual ~SalidaConsola() = default;
+
+    /**
+     * @brief Escribe un bloque de texto
+     * 
+     * @param datos Texto
+     * @param n Cantidad de bytes
+     */
+    virtual void escribir(const char* datos, size_t n) = 0;
+
+    virtual void vaciar() {}        // envia a la consola lo pendiente
+
+    /**
+     * @brief false si la salida descarta todo: quien imprime puede saltarse el trabajo de armar el texto
+     * 
+     */
+    bool activa() const { return activa_; }
+};
+
+/**
+ * @brief Salida interactiva: cada escritura llega de inmediato a la terminal
+ * 
+ */
+class SalidaTerminal : public SalidaConsola {
+private:
+    std::mutex m;
+
+public:
+    void escribir(const char* datos, size_t n) override {
+        std::lock_guard<std::mutex> lock(m);
+        std::cout.write(datos, static_cast<std::streamsize>(n));
+        std::cout.flush();
+    }
+};
+
+/**
+ * @brief Salida con buffer grande: junta el texto y lo escribe en bloques de 1 MiB
+ * 
+ */
+class SalidaBuffer : public SalidaConsola {
+private:
+    static const size_t TAM_BLOQUE = 1 << 20;
+    std::vector<char> buffer;
+    std::mutex m;
+
+    void escribirBloque() {
+        std::cout.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+
+public:
+    SalidaBuffer() { buffer.reserve(TAM_BLOQUE); }
+    ~SalidaBuffer() override { vaciar(); }
+
+    void escribir(const char* datos, size_t n) override {
+        std::lock_guard<std::mutex> lock(m);
+        if (buffer.size() + n > TAM_BLOQUE) escribirBloque();
+        if (n >= TAM_BLOQUE) std::cout.write(datos, static_cast<std::streamsize>(n));
+        else buffer.insert(buffer.end(), datos, datos + n);
+    }
+
+    void vaciar() override {
+        std::lock_guard<std::mutex> lock(m);
+        escribirBloque();
+        std::cout.flush();
+    }
+};
+
+/**
+ * @brief Salida que descarta todo, para que la simulacion solo gaste CPU en la fila y el cobro
+ * 
+ */
+class SalidaNula : public SalidaConsola {
+public:
+    SalidaNula() : SalidaConsola(false) {}
+    void escribir(const char*, size_t) override {}
+};
+
+/**
+ * @brief Salida en memoria: una caja arma aqui el texto de un cliente y luego lo pasa completo a la salida global
+ * 
+ */
+class SalidaMemoria : public SalidaConsola {
+private:
+    std::string texto;
+
+public:
+    explicit SalidaMemoria(bool activa = true) : SalidaConsola(activa) {}
+    void escribir(const char* datos, size_t n) override { texto.append(datos, n); }
+    const std::string& contenido() const { return texto; }
+    void limpiar() { texto.clear(); }       // conserva la memoria reservada para el siguiente cliente
+};
+
+inline SalidaConsola& operator<<(SalidaConsola& s, std::string_view texto) {
+    if (s.activa()) s.escribir(texto.data(), texto.size());
+    return s;
+}
+
+inline SalidaConsola& operator<<(SalidaConsola& s, const char* texto) { return s << std::string_view(texto); }
+inline SalidaConsola& operator<<(SalidaConsola& s, const std::string& texto) { return s << std::string_view(texto); }
+
+inline SalidaConsola& operator<<(SalidaConsola& s, char c) {
+    if (s.activa()) s.escribir(&c, 1);
+    return s;
+}
+
+/**
+ * @brief Imprime numeros sin pasar por iostream
+ * 
+ */
+template <class T>
+typename std::enable_if<std::is_arithmetic<T>::value, SalidaConsola&>::type operator<<(SalidaConsola& s, T valor) {
+    if (!s.activa()) return s;
+    char numero[32];
+    if constexpr (std::is_integral<T>::value) {
+        auto fin = std::to_chars(numero, numero + sizeof(numero), valor).ptr;
+        s.escribir(numero, static_cast<size_t>(fin - numero));
+    } else {
+        int n = snprintf(numero, sizeof(numero), "%g", static_cast<double>(valor));
+        s.escribir(numero, static_cast<size_t>(n));
+    }
+    return s;
+}
+
+inline std::unique_ptr<SalidaConsola> salidaGlobal(new SalidaTerminal());     // salida que usan carritos, fila y cobro
+
+/**
+ * @brief Salida global de la atencion
+ * 
+ * @return SalidaConsola& Salida elegida con --salida
+ */
+inline SalidaConsola& salida() { return *salidaGlobal; }
+
+/**
+ * @brief Identificador compacto de un producto del catalogo
+ * 
+ */
+using IdProducto = uint32_t;
+
+/**
+ * @brief Recurso pmr propio del hilo; nulo = el recurso por defecto del proceso. Con --tiendas cada tienda fija aqui su
+ * arena (y la pasa a sus cajas), asi las tiendas no comparten un recurso
+ * 
+ */
+inline thread_local std::pmr::memory_resource* recursoDelHilo = nullptr;
+
+/**
+ * @brief Recurso del que reservan los carritos, clientes y facturas que se crean en este hilo
+ * 
+ * @return pmr::memory_resource* El recurso del hilo, o el recurso por defecto si el hilo no tiene uno
+ */
+inline std::pmr::memory_resource* recursoActual() {
+    return recursoDelHilo != nullptr ? recursoDelHilo : std::pmr::get_default_resource();
+}
+
+/**
+ * @brief Vista de solo lectura de productos contiguos (como un span de C++20). Se puede recorrer hacia adelante (del
+ * fondo al tope) o al reves con rbegin/rend (del tope al fondo, el orden en que se cobra)
+ * 
+ */
+class VistaProductos {
+private:
+    const IdProducto* inicio = nullptr;
+    size_t cantidad = 0;
+
+public:
+    VistaProductos() = default;
+    VistaProductos(const IdProducto* datos, size_t n) : inicio(datos), cantidad(n) {}
+
+    const IdProducto* begin() const { return inicio; }
+    const IdProducto* end() const { return inicio + cantidad; }
+    std::reverse_iterator<const IdProducto*> rbegin() const { return std::reverse_iterator<const IdProducto*>(end()); }
+    std::reverse_iterator<const IdProducto*> rend() const { return std::reverse_iterator<const IdProducto*>(begin()); }
+    size_t size() const { return cantidad; }
+    bool empty() const { return cantidad == 0; }
+    IdProducto operator[](size_t i) const { return inicio[i]; }
+};
+
+/**
+ * @brief Pila (LIFO) de productos de un carrito. Los primeros 8 productos se guardan dentro del objeto; si el carrito crece
+ * pasan a un bloque contiguo del recurso pmr actual (heap normal o arena de la corrida o de la tienda). A diferencia de std::stack se
+ * puede recorrer sin desarmarla, y moverla nunca reserva memoria
+ * 
+ */
+class PilaCompacta {
+private:
+    static const uint32_t EN_LINEA = 8;     // carritos pequeños: sin memoria dinamica
+    union {
+        IdProducto local[EN_LINEA];
+        IdProducto* externo;
+    };
+    uint32_t cantidad = 0;
+    uint32_t capacidad = EN_LINEA;
+    std::pmr::memory_resource* recurso;      // de donde salio el bloque externo (se devuelve al mismo)
+
+    bool enLinea() const { return capacidad == EN_LINEA; }
+    IdProducto* datos() { return enLinea() ? local : externo; }
+    const IdProducto* datos() const { return enLinea() ? local : externo; }
+
+    void liberar() {
+        if (!enLinea()) recurso->deallocate(externo, capacidad * sizeof(IdProducto), alignof(IdProducto));
+        capacidad = EN_LINEA;
+        cantidad = 0;
+    }
+
+    void crecer(uint32_t minimo) {      // pasa a un bloque externo al menos del doble
+        uint32_t nueva = std::max(minimo, capacidad * 2);
+        IdProducto* bloque = static_cast<IdProducto*>(recurso->allocate(nueva * sizeof(IdProducto), alignof(IdProducto)));
+        memcpy(bloque, datos(), cantidad * sizeof(IdProducto));
+        uint32_t n = cantidad;
+        liberar();
+        externo = bloque;
+        capacidad = nueva;
+        cantidad = n;
+    }
+
+    void tomar(PilaCompacta& otra) {        // se queda con el contenido de otra, que queda vacia
+        recurso = otra.recurso;
+        cantidad = otra.cantidad;
+        capacidad = otra.capacidad;
+        if (otra.enLinea()) memcpy(local, otra.local, cantidad * sizeof(IdProducto));
+        else externo = otra.externo;
+        otra.capacidad = EN_LINEA;
+        otra.cantidad = 0;
+    }
+
+public:
+    PilaCompacta() : recurso(recursoActual()) {}
+
+    /**
+     * @brief Pila con los productos de un rango, del fondo al tope
+     * 
+     */
+    template <class Iterador>
+    PilaCompacta(Iterador primero, Iterador ultimo) : PilaCompacta() {
+        for (; primero != ultimo; ++primero) push(*primero);
+    }
+
+    PilaCompacta(const PilaCompacta& otra) : PilaCompacta() {
+        reservar(otra.cantidad);
+        memcpy(datos(), otra.datos(), otra.cantidad * sizeof(IdProducto));
+        cantidad = otra.cantidad;
+    }
+
+    PilaCompacta(PilaCompacta&& otra) noexcept { tomar(otra); }
+
+    PilaCompacta& operator=(const PilaCompacta& otra) {
+        if (this != &otra) {
+            cantidad = 0;
+            reservar(otra.cantidad);
+            memcpy(datos(), otra.datos(), otra.cantidad * sizeof(IdProducto));
+            cantidad = otra.cantidad;
+        }
+        return *this;
+    }
+
+    PilaCompacta& operator=(PilaCompacta&& otra) noexcept {
+        if (this != &otra) {
+            liberar();
+            tomar(otra);
+        }
+        return *this;
+    }
+
+    ~PilaCompacta() { liberar(); }
+
+    void reservar(size_t n) {       // capacidad para n productos
+        if (n > capacidad) crecer(static_cast<uint32_t>(n));
+    }
+
+    void push(IdProducto id) {
+        if (cantidad == capacidad) crecer(cantidad + 1);
+        datos()[cantidad++] = id;
+    }
+
+    void pop() { --cantidad; }      // la pila no debe estar vacia
+    IdProducto top() const { return datos()[cantidad - 1]; }
+    bool empty() const { return cantidad == 0; }
+    size_t size() const { return cantidad; }
+
+    VistaProductos vista() const { return VistaProductos(datos(), cantidad); }      // del fondo al tope; rbegin/rend del tope al fondo
+};
+
+/**
+ * @brief Pila de productos de un carrito. Carritos, clientes y facturas reservan memoria del recurso pmr actual del hilo
+ * que los crea (recursoActual: el heap normal, la arena de una corrida o la de una tienda)
+ * 
+ */
+using PilaProductos = PilaCompacta;
+using ProductosFactura = std::pmr::vector<std::pair<IdProducto, int>>;      // (producto, precio) de una factura
+
+/**
+ * @brief Arena de memoria de una corrida. Mientras existe es el recurso por defecto de los contenedores pmr, asi que los
+ * carritos, clientes y facturas de la corrida se reservan de ella y se liberan todos juntos al destruirla. Una arena de
+ * un solo hilo (una tienda de --tiendas) no toca el recurso por defecto: queda como recurso del hilo que la crea.
+ * Todo lo que se reservo de la arena debe destruirse antes que ella: los objetos de la corrida se declaran despues de la
+ * arena, la cola global de facturas se vacia antes de terminar, y lo que vive mas que la corrida (los anillos del escritor
+ * del diario) reserva siempre del heap con un recurso explicito
+ * 
+ */
+class ArenaCorrida {
+public:
+    enum class Tipo {
+        Ninguna,        // heap normal (new/delete)
+        Monotona,       // solo crece: reservar es mover un puntero y liberar no hace nada (corridas de un hilo que caben en memoria)
+        Pool            // pools por tamaño con cache por hilo: reutiliza lo liberado y reduce la contencion de malloc entre cajas
+    };
+
+private:
+    /**
+     * @brief Arena monotona que pueden usar varios hilos: reservar es mover un puntero con un mutex tomado
+     * 
+     */
+    class MonotonaSincronizada : public std::pmr::memory_resource {
+    private:
+        std::mutex m;
+        std::pmr::monotonic_buffer_resource base{1 << 20};
+
+        void* do_allocate(size_t bytes, size_t alineacion) override {
+            std::lock_guard<std::mutex> lock(m);
+            return base.allocate(bytes, alineacion);
+        }
+        void do_deallocate(void*, size_t, size_t) override {}      // se libera todo junto al destruir la arena
+        bool do_is_equal(const std::pmr::memory_resource& otro) const noexcept override { return this == &otro; }
+    };
+
+    std::unique_ptr<std::pmr::memory_resource> recurso;
+    std::pmr::memory_resource* anterior = nullptr;
+    bool delHilo;
+
+public:
+    /**
+     * @brief Crea la arena y la deja como recurso por defecto, o solo como recurso del hilo
+     * 
+     * @param tipo Tipo de arena
+     * @param variosHilos Si varios hilos van a reservar a la vez (cajas o terminales en paralelo)
+     * @param soloEsteHilo Si la arena es solo del hilo que la crea (recursoDelHilo) y no de todo el proceso
+     */
+    ArenaCorrida(Tipo tipo, bool variosHilos, bool soloEsteHilo = false) : delHilo(soloEsteHilo) {
+        if (tipo == Tipo::Monotona) {
+            if (variosHilos) recurso.reset(new MonotonaSincronizada());
+            else recurso.reset(new std::pmr::monotonic_buffer_resource(1 << 20));
+        } else if (tipo == Tipo::Pool) {
+            if (variosHilos) recurso.reset(new std::pmr::synchronized_pool_resource());
+            else recurso.reset(new std::pmr::unsynchronized_pool_resource());
+        }
+        if (!recurso) return;
+        if (delHilo) {
+            anterior = recursoDelHilo;
+            recursoDelHilo = recurso.get();
+        } else {
+            anterior = std::pmr::set_default_resource(recurso.get());
+        }
+    }
+
+    ArenaCorrida(const ArenaCorrida&) = delete;
+    ArenaCorrida& operator=(const ArenaCorrida&) = delete;
+
+    ~ArenaCorrida() {       // el recurso devuelve de una vez todos sus bloques
+        if (!recurso) return;
+        if (delHilo) recursoDelHilo = anterior;
+        else std::pmr::set_default_resource(anterior);
+    }
+};
+
+/**
+ * @brief Catalogo de productos: guarda cada nombre una sola vez y le asigna un identificador entero. Los carritos y las
+ * facturas trabajan con identificadores y el nombre solo se busca al mostrarlo
+ * 
+ */
+class CatalogoProductos {
+private:
+    std::deque<std::string> nombres;      // nombres por identificador (deque: las referencias no se invalidan al crecer)
+    std::unordered_map<std::string_view, IdProducto> indice;      // nombre -> identificador, las vistas apuntan a "nombres"
+    mutable std::shared_mutex m;     // muchas lecturas a la vez, una sola escritura al registrar un producto nuevo
+
+public:
+    /**
+     * @brief Devuelve el identificador de un producto, registrandolo si es nuevo
+     * 
+     * @param nombre Nombre del producto
+     * @return IdProducto Identificador del producto
+     */
+    IdProducto registrar(std::string_view nombre) {
+        {
+            std::shared_lock<std::shared_mutex> lectura(m);
+            auto it = indice.find(nombre);
+            if (it != indice.end()) return it->second;      // caso comun: el producto ya existe
+        }
+        std::unique_lock<std::shared_mutex> escritura(m);
+        auto it = indice.find(nombre);      // otro hilo pudo registrarlo mientras se esperaba
+        if (it != indice.end()) return it->second;
+        IdProducto id = static_cast<IdProducto>(nombres.size());
+        nombres.emplace_back(nombre);
+        indice.emplace(nombres.back(), id);
+        return id;
+    }
+
+    /**
+     * @brief Nombre de un producto
+     * 
+     * @param id Identificador devuelto por registrar
+     * @return const string& Nombre del producto
+     */
+    const std::string& nombre(IdProducto id) const {
+        std::shared_lock<std::shared_mutex> lectura(m);
+        return nombres[id];
+    }
+
+    size_t size() const {       // cantidad de productos distintos
+        std::shared_lock<std::shared_mutex> lectura(m);
+        return nombres.size();
+    }
+};
+
+/**
+ * @brief Productos de los estantes del pasillo principal, con el color con que se muestran
+ * 
+ */
+inline const std::vector<std::vector<std::pair<std::string, std::string>>> ESTANTES = {
+    {{"Tomates", ANS_RED}, {"Lechuga", ANS_GREEN}, {"Manzanas", ANS_RED}, {"Galletas", ANS_MAGENTA}, {"Bebidas", ANS_CYAN}},     // estante superior
+    {{"Arroz", ANS_GREEN}, {"Aceite", ANS_YELLOW}, {"Carne", ANS_RED}, {"Galletas", ANS_MAGENTA}, {"Agua", ANS_CYAN}},          // estante medio
+    {{"Leche", ANS_CYAN}, {"Huevos", ANS_GREEN}, {"Pan", ANS_YELLOW}, {"Dulces", ANS_RED}, {"Snacks", ANS_MAGENTA}}            // estante inferior
+};
+
+/**
+ * @brief Catalogo global del D1. La primera vez que se usa se llena con los productos de los estantes
+ * 
+ * @return CatalogoProductos& Catalogo compartido por carritos y facturas
+ */
+inline CatalogoProductos& catalogo() {
+    static CatalogoProductos instancia;
+    static const bool sembrado = []() {     // se ejecuta una sola vez, aunque varios hilos lleguen a la vez
+        for (const auto& estante : ESTANTES)
+            for (const auto& articulo : estante) instancia.registrar(articulo.first);
+        return true;
+    }();
+    (void)sembrado;
+    return instancia;
+}
+
+/**
+ * @brief CLASE CARRITO DE COMPRAS (PILA)
+ * 
+ */
+class CarritoDeCompras {
+private:
+    PilaProductos pila; // atributo de pila para almacenar productos (identificadores del catalogo, 4 bytes cada uno)
+    std::pmr::string nombreCliente; // atributo para identificar de quién es el carrito
+
+public:
+    CarritoDeCompras(std::string_view nombre = "") : nombreCliente(nombre, recursoActual()) {} //Constructor para un carrito con o sin nombre
+
+    /**
+     * @brief Carrito que llega ya lleno (por ejemplo de una traza), sin mostrar cada producto
+     * 
+     * @param nombre Nombre del cliente
+     * @param productos Productos del fondo al tope
+     */
+    CarritoDeCompras(std::string_view nombre, PilaProductos productos) : pila(std::move(productos)), nombreCliente(nombre, recursoActual()) {}
+    
+    /**
+     * @brief Meter elementos al carro de compras
+     * 
+     * @param producto Texto que respresenta el producto metido al carrito
+     */
+    void push(const std::string& producto) {       // agregar producto al carrito por el frente
+        pila.push(catalogo().registrar(producto));      // comando que inserta un producto en la parte superior de la pila (se guarda su identificador)
+        salida() << "Agregado al carro de " << nombreCliente << ": " << producto << "\n";
+    }
+
+    /**
+     * @brief Meter al carro un producto que ya esta en el catalogo
+     * 
+     * @param id Identificador del producto
+     */
+    void push(IdProducto id) {
+        pila.push(id);
+        if (salida().activa()) salida() << "Agregado al carro de " << nombreCliente << ": " << catalogo().nombre(id) << "\n";
+    }
+
+    /**
+     * @brief Eliminar el ultimo elemento insertado al carro de compras
+     * 
+     */
+    void pop() {
+        if (!pila.empty()) {      // verificacion de que no este vacia
+            if (salida().activa()) salida() << "Sacando del carro de " << nombreCliente << ": " << catalogo().nombre(pila.top()) << "\n";       // Obtiene el producto sin eliminarlo
+            pila.pop();       // elimina el producto de la pila
+        } else {      // verificacion si el carro esta vacio
+            salida() << "El carro de " << nombreCliente << " está vacío.\n";
+        }
+    }
+
+    /**
+     * @brief Atributo que devuelve true si la pila esta vacia
+     * 
+     * @return true Si esta vacio
+     * @return false Si tiene algun elemento
+     */
+    bool empty() const {
+        return pila.empty();
+    }
+
+    size_t size() const {       // Devuelve la cantidad de elementos de la pila
+        return pila.size();
+    }
+
+    const PilaProductos& getProductos() const {      // Devuelve la pila sin copiarla ni alterarla
+        return pila;
+    }
+
+    /**
+     * @brief Productos del carrito para recorrerlos sin copiarlos ni sacarlos (mostrar, cobrar, exportar)
+     * 
+     * @return VistaProductos Del fondo al tope; rbegin/rend del tope al fondo
+     */
+    VistaProductos verProductos() const {
+        return pila.vista();
+    }
+
+    /**
+     * @brief Metodo para imprimir productos sin editar la pila original. Recorre la vista de la pila (del fondo al tope)
+     * en lugar de sacar y volver a meter los productos, asi no se copia ni se reserva memoria
+     * 
+     */
+    void mostrarProductos(SalidaConsola& out = salida()) const {
+        if (!out.activa()) return;      // nada que mostrar: no se buscan los nombres
+        out << "Productos en el carrito de " << nombreCliente << ": ";
+        if (pila.empty()) {  // verificar que la pila no este vacia
+            out << "(vacío)";
+        } else {
+            VistaProductos productos = pila.vista();
+            for (size_t i = 0; i < productos.size(); ++i)        // Mostrar en el orden en que se agregaron
+                out << catalogo().nombre(productos[i]) << (i + 1 < productos.size() ? ", " : "");
+        }
+        out << "\n";
+    }
+
+    /**
+     * @brief Atributo que devuelve el nombre del cliente
+     * 
+     * @return string de nombre
+     */
+    const std::pmr::string& getNombreCliente() const {     
+        return nombreCliente;
+    }
+};
+
+
+/**
+ * @brief ESTRUCTURA CLIENTE
+ * 
+ */
+struct Cliente {            // estructura que representa el cliente con el carro
+    std::pmr::string nombre;     // nombre del cliente
+    CarritoDeCompras carrito; // carrito de compras del cliente
+    bool discapacidad : 1;      // si el cliente tiene discapacidad (las tres banderas ocupan un solo byte)
+    bool adultoMayor : 1;       // si el cliente es adulto mayor
+    bool embarazada : 1;        // si el cliente es embarazada
+    int ordenLlegada = 0;       // orden en el que llegó el cliente
+    int64_t llegadaNs = 0;      // instante de llegada (reloj monotono) cuando entra por una terminal concurrente
+
+    Cliente() : nombre(recursoActual()), discapacidad(false), adultoMayor(false), embarazada(false) {}        // cliente vacio, se usa en las celdas del anillo de llegadas
+
+    /**
+     * @brief Construct a new Cliente object
+     * 
+     * @param n Nombre
+     * @param c Carro de compras
+     * @param dis Discapacidad
+     * @param ad Adulto mayor
+     * @param emb Embarazada
+     * @param orden Orden de llegada
+     */
+    Cliente(std::string_view n, CarritoDeCompras c,
+            bool dis, bool ad, bool emb, int orden)       // constructor para inicializar los valores (el carrito se mueve)
+        : nombre(n, recursoActual()), carrito(std::move(c)),
+          discapacidad(dis), adultoMayor(ad),
+          embarazada(emb), ordenLlegada(orden) {}
+};
+
+/**
+ * @brief Instante actual del reloj del sistema en nanosegundos desde 1970 (no reserva memoria ni usa buffers compartidos)
+ * 
+ * @return int64_t Nanosegundos desde la epoca Unix
+ */
+inline int64_t instanteActualNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Convierte un instante a texto con milisegundos, por ejemplo "Sat Oct 17 07:11:10.123 2026". Usa localtime_r /
+ * localtime_s, que no comparten buffer entre hilos como ctime
+ * 
+ * @param instanteNs Nanosegundos desde la epoca Unix
+ * @return string Fecha y hora local
+ */
+inline std::string formatearFechaHora(int64_t instanteNs) {
+    time_t segundos = static_cast<time_t>(instanteNs / 1000000000);
+    int milis = static_cast<int>((instanteNs / 1000000) % 1000);
+    tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &segundos);
+#else
+    localtime_r(&segundos, &local);
+#endif
+    char base[32], texto[64];
+    strftime(base, sizeof(base), "%a %b %d %H:%M:%S", &local);
+    snprintf(texto, sizeof(texto), "%s.%03d %d", base, milis, local.tm_year + 1900);
+    return texto;
+}
+
+/**
+ * @brief Estructura de Factura
+ * 
+ */
+struct Factura {
+    std::pmr::string nombreCliente;
+    ProductosFactura productos;      //Atributo de tipo vector de la factura que almacena 2 valores juntos siendo el producto (identificador del catalogo) y precio
+    int total = 0;
+    int64_t instanteNs = 0;     // momento del cobro (ns desde 1970); el texto se arma solo al mostrarla
+
+    Factura() : nombreCliente(recursoActual()), productos(recursoActual()) {}
+    explicit Factura(std::pmr::memory_resource* recurso) : nombreCliente(recurso), productos(recurso) {}       // factura vacia que reserva de 'recurso' (celdas del anillo del escritor)
+    Factura(std::string_view nombre, ProductosFactura prods, int tot, int64_t instante)     //Constructor para inicializar los valores (los productos se mueven, no se copian)
+        : nombreCliente(nombre, recursoActual()), productos(std::move(prods)), total(tot), instanteNs(instante) {}
+
+    std::string fechaHora() const { return formatearFechaHora(instanteNs); }     // fecha y hora en texto
+};
+
+/**
+ * @brief Archivo de solo lectura mapeado en memoria. En Windows se lee completo a un buffer
+ * 
+ */
+class ArchivoMapeado {
+private:
+    const char* datos = nullptr;
+    size_t tam = 0;
+#ifdef _WIN32
+    std::vector<char> copia;
+#endif
+
+public:
+    ArchivoMapeado() = default;
+    ArchivoMapeado(const ArchivoMapeado&) = delete;
+    ArchivoMapeado& operator=(const ArchivoMapeado&) = delete;
+    ~ArchivoMapeado() { cerrar(); }
+
+    /**
+     * @brief Mapea un archivo completo
+     * 
+     * @param ruta Archivo
+     * @param error Mensaje si falla
+     * @return true Si se pudo mapear
+     */
+    bool abrir(const std::string& ruta, std::string& error) {
+        cerrar();
+#ifdef _WIN32
+        std::ifstream archivo(ruta, std::ios::binary);
+        if (!archivo) {
+            error = "No se pudo abrir " + ruta;
+            return false;
+        }
+        copia.assign(std::istreambuf_iterator<char>(archivo), std::istreambuf_iterator<char>());
+        datos = copia.data();
+        tam = copia.size();
+#else
+        int fd = open(ruta.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = "No se pudo abrir " + ruta;
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            error = "No se pudo leer el tamaño de " + ruta;
+            return false;
+        }
+        tam = static_cast<size_t>(info.st_size);
+        if (tam > 0) {
+            void* p = mmap(nullptr, tam, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                close(fd);
+                tam = 0;
+                error = "No se pudo mapear " + ruta;
+                return false;
+            }
+            madvise(p, tam, MADV_SEQUENTIAL);       // se recorre de principio a fin
+            datos = static_cast<const char*>(p);
+        }
+        close(fd);      // el mapeo sigue valido sin el descriptor
+#endif
+        return true;
+    }
+
+    void cerrar() {
+#ifdef _WIN32
+        copia.clear();
+#else
+        if (datos) munmap(const_cast<char*>(datos), tam);
+#endif
+        datos = nullptr;
+        tam = 0;
+    }
+
+    const char* data() const { return datos; }
+    size_t size() const { return tam; }
+};
+
+#endif
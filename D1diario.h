@@ -0,0 +1,342 @@
+/**
+ * @file D1diario.h
+ * @author Juan Bohorquez (jbohorquezsa@unal.edu.co)
+ * @author Julian Quintero (julquinteroca@unal.edu.co)
+ * @author Santiago Herrera (sanherrerapa@unal.edu.co)
+ *
+ * @brief Diario de facturas en disco: el escritor de solo agregado y el lector que recorre el archivo
+ * mapeado validando cada registro
+ * @version 0.2
+ * @date 2025-10-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef D1_DIARIO_H
+#define D1_DIARIO_H
+
+#include "D1comun.h"
+#include <cerrno>    // errno de una escritura fallida
+
+/**
+ * @brief Formato del diario de facturas: cabecera "D1FJ" + version (uint32), luego registros con prefijo de longitud:
+ * uint32 longitud del resto, uint8 tipo y los datos. Tipo 'P' (producto): uint32 id, uint16 largo, nombre. Tipo 'F'
+ * (factura): uint16 largo y nombre del cliente, int64 instante (ns desde 1970), int64 total, uint32 cantidad y por cada
+ * producto uint32 id e int32 precio. Los enteros se guardan en el orden de bytes de la maquina. La version 1 guardaba la
+ * fecha como texto (uint16 largo y bytes) en lugar del instante; todavia se puede leer
+ * 
+ */
+inline const char MAGIA_DIARIO[4] = {'D', '1', 'F', 'J'};
+inline const uint32_t VERSION_DIARIO = 2;
+
+/**
+ * @brief Identificadores de producto que acepta el lector (y catalogo maximo del perfil de carga). El lector guarda los
+ * nombres en un vector indexado por identificador: un id dañado no debe pedir gigas de memoria
+ * 
+ */
+inline const uint32_t MAX_PRODUCTOS_DIARIO = 1u << 22;
+
+/**
+ * @brief Diario de facturas de solo agregado. Cada factura se serializa en un buffer que se escribe al archivo en bloques
+ * grandes, asi la memoria del programa no crece con la cantidad de facturas
+ * 
+ */
+class DiarioFacturas {
+private:
+    FILE* archivo = nullptr;
+    std::vector<char> buffer;        // registros pendientes de escribir
+    std::vector<bool> productoEscrito;       // productos cuyo nombre ya esta en el diario
+    size_t facturas = 0;        // facturas escritas en esta corrida
+    size_t facturasEnBuffer = 0;        // de ellas, las que aun estan en el buffer
+    uint64_t inicioCorrida = 8;     // posicion donde empiezan los registros de esta corrida
+    std::string errorEscritura;      // primera escritura fallida; desde ahi no se escribe nada mas
+    std::mutex m;        // varias cajas pueden registrar facturas a la vez
+    static const size_t TAM_BLOQUE = 1 << 20;       // se escribe al archivo cada 1 MiB
+
+    template <class T>
+    void poner(T valor) {       // agrega un entero al buffer
+        const char* p = reinterpret_cast<const char*>(&valor);
+        buffer.insert(buffer.end(), p, p + sizeof(T));
+    }
+
+    void ponerTexto(std::string_view texto) {        // largo (uint16) y bytes
+        uint16_t largo = static_cast<uint16_t>(std::min<size_t>(texto.size(), 0xFFFF));
+        poner(largo);
+        buffer.insert(buffer.end(), texto.data(), texto.data() + largo);
+    }
+
+    /**
+     * @brief Escribe la longitud de un registro ya serializado desde la posicion inicio
+     * 
+     * @param inicio Posicion del campo de longitud en el buffer
+     */
+    void cerrarRegistro(size_t inicio) {
+        uint32_t largo = static_cast<uint32_t>(buffer.size() - inicio - sizeof(uint32_t));
+        memcpy(buffer.data() + inicio, &largo, sizeof(largo));
+    }
+
+    /**
+     * @brief Escribe el buffer al archivo. Si falla (disco lleno, por ejemplo) se guarda el error y no se escribe nada
+     * mas: agregar registros despues de uno escrito a medias dañaria el diario en el medio y no solo al final
+     * 
+     */
+    void escribirBuffer() {
+        if (!buffer.empty() && errorEscritura.empty() && fwrite(buffer.data(), 1, buffer.size(), archivo) != buffer.size())
+            errorEscritura = std::string("No se pudo escribir el diario de facturas (") + strerror(errno) + "); las facturas "
+                             "desde la " + std::to_string(facturas - facturasEnBuffer + 1) + " no quedaron guardadas";
+        buffer.clear();
+        facturasEnBuffer = 0;
+    }
+
+public:
+    ~DiarioFacturas() { cerrar(); }
+
+    /**
+     * @brief Abre el diario para agregar facturas al final. Si el archivo es nuevo se escribe la cabecera
+     * 
+     * @param ruta Archivo del diario
+     * @param error Mensaje si falla
+     * @return true Si se pudo abrir
+     */
+    bool abrir(const std::string& ruta, std::string& error) {
+        std::lock_guard<std::mutex> lock(m);
+        archivo = fopen(ruta.c_str(), "ab");
+        if (!archivo) {
+            error = "No se pudo abrir el diario " + ruta;
+            return false;
+        }
+        setvbuf(archivo, nullptr, _IONBF, 0);       // el buffer propio ya agrupa las escrituras
+        fseek(archivo, 0, SEEK_END);
+        inicioCorrida = static_cast<uint64_t>(ftell(archivo));
+        if (inicioCorrida == 0) {
+            inicioCorrida = 8;
+            buffer.insert(buffer.end(), MAGIA_DIARIO, MAGIA_DIARIO + 4);
+            poner(VERSION_DIARIO);
+            escribirBuffer();
+        } else {        // el diario ya existe: los nombres de producto se vuelven a escribir por si el catalogo cambio
+            ArchivoMapeado existente;
+            if (!existente.abrir(ruta, error) || existente.size() < 8 || memcmp(existente.data(), MAGIA_DIARIO, 4) != 0) {
+                fclose(archivo);
+                archivo = nullptr;
+                error = ruta + " no es un diario de facturas";
+                return false;
+            }
+            uint32_t version;
+            memcpy(&version, existente.data() + 4, 4);
+            if (version != VERSION_DIARIO) {        // no se mezclan formatos en un mismo archivo
+                fclose(archivo);
+                archivo = nullptr;
+                error = ruta + " es un diario de la versión " + std::to_string(version) + "; usa otro archivo";
+                return false;
+            }
+        }
+        buffer.reserve(TAM_BLOQUE + 4096);
+        return true;
+    }
+
+    bool abierto() const { return archivo != nullptr; }
+
+    /**
+     * @brief Agrega una factura al diario. Antes escribe el nombre de los productos que aun no aparecen en el
+     * 
+     * @param f Factura terminada
+     */
+    void agregar(const Factura& f) {
+        std::lock_guard<std::mutex> lock(m);
+        for (const auto& p : f.productos) {
+            if (p.first < productoEscrito.size() && productoEscrito[p.first]) continue;
+            if (p.first >= productoEscrito.size()) productoEscrito.resize(p.first + 1, false);
+            productoEscrito[p.first] = true;
+            size_t inicio = buffer.size();
+            poner(uint32_t(0));
+            poner(uint8_t('P'));
+            poner(uint32_t(p.first));
+            ponerTexto(catalogo().nombre(p.first));
+            cerrarRegistro(inicio);
+        }
+
+        size_t inicio = buffer.size();
+        poner(uint32_t(0));
+        poner(uint8_t('F'));
+        ponerTexto(f.nombreCliente);
+        poner(int64_t(f.instanteNs));
+        poner(int64_t(f.total));
+        poner(uint32_t(f.productos.size()));
+        for (const auto& p : f.productos) {
+            poner(uint32_t(p.first));
+            poner(int32_t(p.second));
+        }
+        cerrarRegistro(inicio);
+        ++facturas;
+        ++facturasEnBuffer;
+
+        if (buffer.size() >= TAM_BLOQUE) escribirBuffer();
+    }
+
+    /**
+     * @brief Escribe lo pendiente y cierra el archivo
+     * 
+     */
+    void cerrar() {
+        std::lock_guard<std::mutex> lock(m);
+        if (!archivo) return;
+        escribirBuffer();
+        fclose(archivo);
+        archivo = nullptr;
+    }
+
+    size_t facturasEscritas() const { return facturas; }
+    const std::string& getErrorEscritura() const { return errorEscritura; }        // vacio si todo se escribio
+    uint64_t getInicioCorrida() const { return inicioCorrida; }     // para leer solo las facturas de esta corrida
+};
+
+/**
+ * @brief Factura leida del diario. Los textos apuntan directamente al archivo mapeado
+ * 
+ */
+struct FacturaLeida {
+    std::string_view nombreCliente;
+    int64_t instanteNs = 0;
+    std::string_view fechaTexto;     // solo en diarios de la version 1
+    int64_t total = 0;
+    uint32_t cantidad = 0;      // productos de la factura
+    const char* productos = nullptr;        // cantidad pares (uint32 id, int32 precio)
+
+    /**
+     * @brief Producto i de la factura
+     * 
+     * @param i Posicion
+     * @return pair<IdProducto, int> Identificador (del diario) y precio
+     */
+    std::pair<IdProducto, int> producto(uint32_t i) const {
+        uint32_t id;
+        int32_t precio;
+        memcpy(&id, productos + i * 8, 4);
+        memcpy(&precio, productos + i * 8 + 4, 4);
+        return {id, precio};
+    }
+
+    std::string fechaHora() const {      // fecha y hora en texto, se arma solo cuando se muestra
+        return fechaTexto.empty() ? formatearFechaHora(instanteNs) : std::string(fechaTexto);
+    }
+};
+
+/**
+ * @brief Lector del diario de facturas sobre un archivo mapeado en memoria, para el reporte final y el analisis fuera de linea
+ * 
+ */
+class LectorDiario {
+private:
+    ArchivoMapeado mapa;
+    std::vector<std::string_view> nombresProducto;        // nombres por identificador, tal como aparecen en el diario
+    uint32_t version = VERSION_DIARIO;
+
+public:
+    bool abrir(const std::string& ruta, std::string& error) {
+        if (!mapa.abrir(ruta, error)) return false;
+        if (mapa.size() < 8 || memcmp(mapa.data(), MAGIA_DIARIO, 4) != 0) {
+            error = ruta + " no es un diario de facturas";
+            return false;
+        }
+        memcpy(&version, mapa.data() + 4, 4);
+        if (version != 1 && version != VERSION_DIARIO) {
+            error = ruta + ": versión de diario no soportada (" + std::to_string(version) + ")";
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Nombre de un producto segun los registros 'P' ya recorridos
+     * 
+     * @param id Identificador guardado en la factura
+     * @return string_view Nombre (vacio si no se conoce)
+     */
+    std::string_view nombreProducto(IdProducto id) const {
+        return id < nombresProducto.size() ? nombresProducto[id] : std::string_view();
+    }
+
+    /**
+     * @brief Recorre todas las facturas en orden
+     * 
+     * @param visitar Funcion que recibe cada FacturaLeida
+     * @param error Mensaje si el archivo esta dañado
+     * @param desde Posicion del primer registro (8 = todo el diario)
+     * @return true Si se recorrio completo
+     */
+    template <class Visitante>
+    bool recorrer(Visitante visitar, std::string& error, uint64_t desde = 8) {
+        const char* p = mapa.data() + std::min<uint64_t>(std::max<uint64_t>(desde, 8), mapa.size());
+        const char* fin = mapa.data() + mapa.size();
+
+        while (p < fin) {
+            uint32_t largo;
+            if (fin - p < 5) break;     // registro incompleto al final (corrida interrumpida)
+            memcpy(&largo, p, 4);
+            const char* registro = p + 4;
+            if (static_cast<size_t>(fin - registro) < largo) break;
+            const char* finRegistro = registro + largo;
+            p = finRegistro;
+
+            // cada campo se lee solo si cabe en el registro: un largo dañado no lee fuera del mapeo ni del registro
+            const char* q = registro;
+            bool sano = true;
+            auto tomar = [&](void* destino, size_t n) {
+                if (!sano || static_cast<size_t>(finRegistro - q) < n) {
+                    sano = false;
+                    return;
+                }
+                memcpy(destino, q, n);
+                q += n;
+            };
+            auto leerTexto = [&]() {
+                uint16_t largoTexto = 0;
+                tomar(&largoTexto, 2);
+                if (!sano || static_cast<size_t>(finRegistro - q) < largoTexto) {
+                    sano = false;
+                    return std::string_view();
+                }
+                std::string_view texto(q, largoTexto);
+                q += largoTexto;
+                return texto;
+            };
+
+            char tipo = 0;
+            tomar(&tipo, 1);
+            if (!sano) {
+                error = "Registro dañado en el diario";
+                return false;
+            }
+            if (tipo == 'P') {
+                uint32_t id = 0;
+                tomar(&id, 4);
+                std::string_view nombre = leerTexto();
+                if (!sano || q != finRegistro || id >= MAX_PRODUCTOS_DIARIO) {
+                    error = "Producto dañado en el diario";
+                    return false;
+                }
+                if (id >= nombresProducto.size()) nombresProducto.resize(id + 1);
+                nombresProducto[id] = nombre;
+            } else if (tipo == 'F') {
+                FacturaLeida f;
+                f.nombreCliente = leerTexto();
+                if (version == 1) f.fechaTexto = leerTexto();
+                else tomar(&f.instanteNs, 8);
+                tomar(&f.total, 8);
+                tomar(&f.cantidad, 4);
+                if (!sano || static_cast<size_t>(finRegistro - q) != f.cantidad * 8ULL) {
+                    error = "Factura dañada en el diario";
+                    return false;
+                }
+                f.productos = q;
+                visitar(static_cast<const FacturaLeida&>(f));
+            } else {
+                error = std::string("Tipo de registro desconocido en el diario: ") + tipo;
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif
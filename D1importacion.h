@@ -0,0 +1,580 @@
+/**
+ * @file D1importacion.h
+ * @author Juan Bohorquez (jbohorquezsa@unal.edu.co)
+ * @author Julian Quintero (julquinteroca@unal.edu.co)
+ * @author Santiago Herrera (sanherrerapa@unal.edu.co)
+ *
+ * @brief Importacion masiva de clientes desde CSV o JSON (--importar y la opcion I del menu)
+ * @version 0.2
+ * @date 2025-10-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef D1_IMPORTACION_H
+#define D1_IMPORTACION_H
+
+#include <deque>     // Textos limpios de cada trozo (no se mueven al crecer)
+#include <limits>    // Limite de productos por archivo
+#include <thread>    // Un hilo lector por trozo del archivo
+
+#include "D1comun.h"
+
+/**
+ * @brief Importacion masiva de clientes desde CSV o JSON, con las reglas del modo manual: nombre no vacio, una de las 4
+ * opciones de askPriorityFlags y los productos en orden, donde BORRAR, ELIMINAR o DESHACER (en mayusculas o minusculas)
+ * quitan el ultimo producto del carrito.
+ * CSV: una linea por cliente "nombre,prioridad,productos", con los productos separados por '|'. Un campo puede ir entre
+ * comillas dobles ("" adentro es una comilla, y despues de cerrarla solo puede venir la coma) pero no puede ocupar varias
+ * lineas; si el primer campo de la primera linea es "nombre" o "cliente", la linea se toma como encabezado. JSON: un arreglo de objetos (o un objeto por linea) con "nombre",
+ * "prioridad" (1-4, como numero o texto) y "productos" (arreglo de textos, opcional); las demas claves se ignoran.
+ * Igual que TrazaLlegadas, el archivo se mapea y se reparte en trozos que se leen en paralelo (en JSON antes se recorre una
+ * vez para saber donde empieza cada objeto). Los clientes se arman al final, todos juntos, para meterlos a la fila de una vez
+ * 
+ */
+class ImportacionClientes {
+private:
+    struct Registro {
+        std::string_view nombre;         // dentro del archivo mapeado, o en los textos del trozo si traia comillas o escapes
+        uint32_t primerProducto;    // posicion en los productos del trozo
+        uint32_t cantidad;
+        char opcion;                // 1-4 como en askPriorityFlags; 0 = todavia no se leyo
+    };
+
+    /**
+     * @brief Resultado de un hilo lector
+     * 
+     */
+    struct Trozo {
+        std::vector<Registro> registros;
+        std::vector<IdProducto> productos;
+        std::deque<std::string> textos;       // textos que hubo que limpiar (deque: no se mueven, las vistas siguen validas)
+        std::unordered_map<std::string_view, IdProducto> vistos;      // cache del hilo: evita el candado del catalogo en productos repetidos
+        const char* posError = nullptr;     // donde esta el primer error del trozo
+        std::string error;
+
+        bool fallar(const char* pos, const std::string& mensaje) {
+            posError = pos;
+            error = mensaje;
+            return false;
+        }
+
+        /**
+         * @brief Agrega un producto al carrito del registro, o quita el ultimo si es una palabra de deshacer
+         * 
+         * @param r Cliente que se esta leyendo (sus productos son los ultimos del trozo)
+         * @param producto Nombre del producto
+         */
+        void agregarProducto(Registro& r, std::string_view producto) {
+            if (esDeshacer(producto)) {
+                if (r.cantidad > 0) {       // con el carrito vacio no hay nada que quitar, como en el modo manual
+                    productos.pop_back();
+                    --r.cantidad;
+                }
+                return;
+            }
+            auto it = vistos.find(producto);
+            if (it == vistos.end()) it = vistos.emplace(producto, catalogo().registrar(producto)).first;
+            productos.push_back(it->second);
+            ++r.cantidad;
+        }
+
+        /**
+         * @brief Agrega los productos de un campo separado por '|'
+         * 
+         * @param r Cliente que se esta leyendo
+         * @param campo Productos separados por '|' (se ignoran los vacios)
+         */
+        void agregarProductos(Registro& r, std::string_view campo) {
+            for (std::string_view resto = campo; !resto.empty(); ) {
+                size_t sep = resto.find('|');
+                std::string_view producto = recortar(resto.substr(0, sep));
+                resto.remove_prefix(sep == std::string_view::npos ? resto.size() : sep + 1);
+                if (!producto.empty()) agregarProducto(r, producto);
+            }
+        }
+    };
+
+    ArchivoMapeado archivo;
+    std::vector<Trozo> trozos;       // en el orden del archivo
+    size_t totalRegistros = 0;
+
+    static bool igualSinMayusculas(std::string_view texto, std::string_view palabra) {        // palabra va en mayusculas
+        if (texto.size() != palabra.size()) return false;
+        for (size_t i = 0; i < palabra.size(); ++i)
+            if (toupper(static_cast<unsigned char>(texto[i])) != palabra[i]) return false;
+        return true;
+    }
+
+    static bool esDeshacer(std::string_view producto) {       // BORRAR, ELIMINAR o DESHACER sin importar mayusculas
+        return igualSinMayusculas(producto, "BORRAR") || igualSinMayusculas(producto, "ELIMINAR") ||
+               igualSinMayusculas(producto, "DESHACER");
+    }
+
+    static bool esEncabezado(std::string_view primerCampo) {
+        return igualSinMayusculas(primerCampo, "NOMBRE") || igualSinMayusculas(primerCampo, "CLIENTE");
+    }
+
+    static std::string_view recortar(std::string_view s) {        // quita espacios y tabuladores de los extremos
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+        return s;
+    }
+
+    static bool opcionValida(std::string_view s) { return s.size() == 1 && s[0] >= '1' && s[0] <= '4'; }
+
+    /**
+     * @brief Parte una linea CSV en campos
+     * 
+     * @param linea Linea sin el salto
+     * @param campos Hasta 4 campos (el cuarto solo indica que sobran campos)
+     * @param trozo Donde se guardan los campos con comillas dobladas
+     * @return int Cantidad de campos, -1 si una comilla no se cierra o -2 si despues de cerrarla hay algo mas que la coma
+     */
+    static int camposCsv(std::string_view linea, std::string_view campos[4], Trozo& trozo) {
+        int cantidad = 0;
+        std::string_view resto = linea;
+        while (cantidad < 4) {
+            size_t sigue = resto.find(',');
+            std::string_view campo = recortar(resto.substr(0, sigue));
+            std::string_view inicio = recortar(resto);
+            if (!inicio.empty() && inicio[0] == '"') {      // campo entre comillas: puede tener comas y "" adentro
+                size_t j = 1;
+                bool dobladas = false;
+                while (true) {
+                    size_t q = inicio.find('"', j);
+                    if (q == std::string_view::npos) return -1;
+                    if (q + 1 < inicio.size() && inicio[q + 1] == '"') {
+                        dobladas = true;
+                        j = q + 2;
+                        continue;
+                    }
+                    campo = inicio.substr(1, q - 1);
+                    size_t coma = inicio.find(',', q + 1);
+                    if (!recortar(inicio.substr(q + 1, coma == std::string_view::npos ? std::string_view::npos : coma - q - 1)).empty())
+                        return -2;      // "Ana"x,... no se corta en silencio
+                    sigue = coma == std::string_view::npos ? std::string_view::npos : static_cast<size_t>(inicio.data() - resto.data()) + coma;
+                    break;
+                }
+                if (dobladas) {
+                    trozo.textos.emplace_back();
+                    std::string& limpio = trozo.textos.back();
+                    for (size_t k = 0; k < campo.size(); ++k) {
+                        limpio.push_back(campo[k]);
+                        if (campo[k] == '"') ++k;
+                    }
+                    campo = limpio;
+                }
+            }
+            campos[cantidad++] = campo;
+            if (sigue == std::string_view::npos) break;
+            resto.remove_prefix(sigue + 1);
+        }
+        return cantidad;
+    }
+
+    /**
+     * @brief Lee las lineas completas de un trozo CSV
+     * 
+     * @param texto Trozo que empieza y termina en un limite de linea
+     * @param trozo Resultado del trozo
+     * @param primero Si el trozo es el comienzo del archivo (puede traer encabezado)
+     */
+    static void leerCsv(std::string_view texto, Trozo& trozo, bool primero) {
+        trozo.registros.reserve(static_cast<size_t>(std::count(texto.begin(), texto.end(), '\n')) + 1);
+        bool puedeSerEncabezado = primero;
+        while (!texto.empty()) {
+            size_t fin = texto.find('\n');
+            std::string_view linea = texto.substr(0, fin);
+            texto.remove_prefix(fin == std::string_view::npos ? texto.size() : fin + 1);
+            if (!linea.empty() && linea.back() == '\r') linea.remove_suffix(1);       // archivos guardados en Windows
+            if (recortar(linea).empty()) continue;
+
+            std::string_view campos[4];
+            int cantidad = camposCsv(linea, campos, trozo);
+            bool encabezado = puedeSerEncabezado && cantidad > 0 && esEncabezado(campos[0]);     // otra primera linea se valida como cliente
+            puedeSerEncabezado = false;
+            if (encabezado) continue;
+            if (cantidad == -1) return (void)trozo.fallar(linea.data(), "falta cerrar una comilla");
+            if (cantidad == -2) return (void)trozo.fallar(linea.data(), "después de cerrar una comilla solo puede ir una coma");
+            if (cantidad < 2 || cantidad > 3) return (void)trozo.fallar(linea.data(), "se esperaba nombre,prioridad,productos");
+            if (campos[0].empty()) return (void)trozo.fallar(linea.data(), "el nombre no puede estar vacío");
+            if (!opcionValida(campos[1])) return (void)trozo.fallar(linea.data(), "la prioridad debe ser 1, 2, 3 o 4");
+
+            Registro r{campos[0], static_cast<uint32_t>(trozo.productos.size()), 0, campos[1][0]};
+            if (cantidad == 3) trozo.agregarProductos(r, campos[2]);
+            trozo.registros.push_back(r);
+        }
+    }
+
+    /**
+     * @brief Lector de un trozo JSON: uno o varios objetos cliente separados por comas
+     * 
+     */
+    struct LectorJson {
+        const char* p;
+        const char* fin;
+        Trozo& trozo;
+
+        void espacios() {
+            while (p < fin && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) ++p;
+        }
+
+        static void ponerUtf8(std::string& s, uint32_t c) {
+            if (c < 0x80) {
+                s.push_back(static_cast<char>(c));
+            } else if (c < 0x800) {
+                s.push_back(static_cast<char>(0xC0 | (c >> 6)));
+                s.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+            } else if (c < 0x10000) {
+                s.push_back(static_cast<char>(0xE0 | (c >> 12)));
+                s.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+                s.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+            } else {
+                s.push_back(static_cast<char>(0xF0 | (c >> 18)));
+                s.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+                s.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+                s.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+            }
+        }
+
+        bool hex4(uint32_t& c) {
+            if (fin - p < 4) return false;
+            c = 0;
+            for (int i = 0; i < 4; ++i, ++p) {
+                char h = *p;
+                c <<= 4;
+                if (h >= '0' && h <= '9') c |= h - '0';
+                else if (h >= 'a' && h <= 'f') c |= h - 'a' + 10;
+                else if (h >= 'A' && h <= 'F') c |= h - 'A' + 10;
+                else return false;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Lee un texto; si no tiene escapes queda apuntando al archivo
+         * 
+         * @param salida Texto sin comillas ni escapes
+         * @return true Si el texto es valido
+         */
+        bool texto(std::string_view& salida) {
+            const char* inicio = p;
+            if (p >= fin || *p != '"') return trozo.fallar(inicio, "se esperaba un texto entre comillas");
+            ++p;
+            const char* cuerpo = p;
+            while (p < fin && *p != '"' && *p != '\\') ++p;
+            if (p < fin && *p == '"') {     // caso comun: sin escapes
+                salida = std::string_view(cuerpo, p - cuerpo);
+                ++p;
+                return true;
+            }
+            trozo.textos.emplace_back(cuerpo, p - cuerpo);
+            std::string& limpio = trozo.textos.back();
+            while (p < fin && *p != '"') {
+                if (*p != '\\') {
+                    limpio.push_back(*p++);
+                    continue;
+                }
+                if (++p >= fin) break;
+                char e = *p++;
+                uint32_t c;
+                switch (e) {
+                    case '"': case '\\': case '/': limpio.push_back(e); break;
+                    case 'b': limpio.push_back('\b'); break;
+                    case 'f': limpio.push_back('\f'); break;
+                    case 'n': limpio.push_back('\n'); break;
+                    case 'r': limpio.push_back('\r'); break;
+                    case 't': limpio.push_back('\t'); break;
+                    case 'u':
+                        if (!hex4(c)) return trozo.fallar(inicio, "escape \\u inválido");
+                        if (c >= 0xD800 && c < 0xDC00 && fin - p >= 6 && p[0] == '\\' && p[1] == 'u') {      // par sustituto
+                            uint32_t bajo;
+                            p += 2;
+                            if (!hex4(bajo) || bajo < 0xDC00 || bajo > 0xDFFF) return trozo.fallar(inicio, "escape \\u inválido");
+                            c = 0x10000 + ((c - 0xD800) << 10) + (bajo - 0xDC00);
+                        }
+                        ponerUtf8(limpio, c);
+                        break;
+                    default:
+                        return trozo.fallar(inicio, "escape inválido en un texto");
+                }
+            }
+            if (p >= fin) return trozo.fallar(inicio, "falta cerrar un texto");
+            ++p;
+            salida = limpio;
+            return true;
+        }
+
+        bool saltarValor() {        // valor de una clave que no se usa
+            espacios();
+            if (p < fin && *p == '"') {
+                std::string_view ignorado;
+                return texto(ignorado);
+            }
+            if (p < fin && (*p == '{' || *p == '[')) {
+                int profundidad = 0;
+                do {
+                    if (*p == '"') {
+                        std::string_view ignorado;
+                        if (!texto(ignorado)) return false;
+                        continue;
+                    }
+                    if (*p == '{' || *p == '[') ++profundidad;
+                    else if (*p == '}' || *p == ']') --profundidad;
+                    ++p;
+                } while (profundidad > 0 && p < fin);
+                return profundidad == 0 || trozo.fallar(p, "JSON incompleto");
+            }
+            const char* inicio = p;
+            while (p < fin && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t') ++p;
+            return p > inicio || trozo.fallar(inicio, "se esperaba un valor");
+        }
+
+        /**
+         * @brief Lee un objeto cliente y lo agrega al trozo
+         * 
+         * @return true Si el objeto es un cliente valido
+         */
+        bool objeto() {
+            const char* inicio = p;
+            Registro r{std::string_view(), static_cast<uint32_t>(trozo.productos.size()), 0, 0};
+            bool conNombre = false;
+            ++p;        // '{'
+            espacios();
+            if (p < fin && *p == '}') {
+                ++p;
+            } else {
+                while (true) {
+                    espacios();
+                    std::string_view clave;
+                    if (!texto(clave)) return false;
+                    espacios();
+                    if (p >= fin || *p != ':') return trozo.fallar(p, "se esperaba ':'");
+                    ++p;
+                    espacios();
+                    if (clave == "nombre") {
+                        if (!texto(r.nombre)) return false;
+                        r.nombre = recortar(r.nombre);
+                        conNombre = true;
+                    } else if (clave == "prioridad") {
+                        const char* valor = p;
+                        std::string_view opcion;
+                        if (p < fin && *p == '"') {
+                            if (!texto(opcion)) return false;
+                        } else {
+                            while (p < fin && *p >= '0' && *p <= '9') ++p;
+                            opcion = std::string_view(valor, p - valor);
+                        }
+                        if (!opcionValida(opcion)) return trozo.fallar(valor, "la prioridad debe ser 1, 2, 3 o 4");
+                        r.opcion = opcion[0];
+                    } else if (clave == "productos") {
+                        if (p >= fin || *p != '[') return trozo.fallar(p, "\"productos\" debe ser un arreglo de textos");
+                        ++p;
+                        espacios();
+                        while (p < fin && *p != ']') {
+                            std::string_view producto;
+                            if (*p != '"') return trozo.fallar(p, "\"productos\" debe ser un arreglo de textos");
+                            if (!texto(producto)) return false;
+                            producto = recortar(producto);
+                            if (!producto.empty()) trozo.agregarProducto(r, producto);
+                            espacios();
+                            if (p < fin && *p == ',') {
+                                ++p;
+                                espacios();
+                            } else if (p < fin && *p != ']') {
+                                return trozo.fallar(p, "se esperaba ',' o ']'");
+                            }
+                        }
+                        if (p >= fin) return trozo.fallar(inicio, "JSON incompleto");
+                        ++p;
+                    } else if (!saltarValor()) {
+                        return false;
+                    }
+                    espacios();
+                    if (p < fin && *p == ',') {
+                        ++p;
+                        continue;
+                    }
+                    if (p < fin && *p == '}') {
+                        ++p;
+                        break;
+                    }
+                    return trozo.fallar(p < fin ? p : inicio, "se esperaba ',' o '}'");
+                }
+            }
+            if (!conNombre || r.nombre.empty()) return trozo.fallar(inicio, "el nombre no puede estar vacío");
+            if (r.opcion == 0) return trozo.fallar(inicio, "la prioridad debe ser 1, 2, 3 o 4");
+            trozo.registros.push_back(r);
+            return true;
+        }
+    };
+
+    /**
+     * @brief Lee los objetos de un trozo JSON
+     * 
+     * @param texto Desde el comienzo de un objeto hasta el comienzo del primer objeto del trozo siguiente (o el final)
+     * @param trozo Resultado del trozo
+     */
+    static void leerJson(std::string_view texto, Trozo& trozo) {
+        LectorJson lector{texto.data(), texto.data() + texto.size(), trozo};
+        while (true) {
+            lector.espacios();
+            if (lector.p < lector.fin && *lector.p == ',') {
+                ++lector.p;
+                continue;
+            }
+            if (lector.p >= lector.fin || *lector.p == ']') return;     // fin del trozo o del arreglo
+            if (*lector.p != '{') return (void)trozo.fallar(lector.p, "se esperaba un objeto cliente");
+            if (!lector.objeto()) return;
+        }
+    }
+
+    /**
+     * @brief Recorre el JSON una vez para encontrar donde empieza cada objeto cliente, sin interpretarlos
+     * 
+     * @param texto Archivo completo
+     * @param inicios Posicion de cada objeto
+     * @param posError Donde esta el error si el JSON no cierra (el comienzo del cliente que quedo abierto)
+     * @param motivo Descripcion del error
+     * @return true Si los textos, llaves y corchetes cierran y despues del arreglo solo hay espacios
+     */
+    static bool ubicarObjetos(std::string_view texto, std::vector<size_t>& inicios, size_t& posError, const char*& motivo) {
+        motivo = "JSON incompleto o mal cerrado";
+        size_t i = 0;
+        while (i < texto.size() && isspace(static_cast<unsigned char>(texto[i]))) ++i;
+        int base = (i < texto.size() && texto[i] == '[') ? 1 : 0;      // arreglo de clientes o un objeto por linea
+        int profundidad = 0;
+        for (; i < texto.size(); ++i) {
+            char c = texto[i];
+            if (c == '"') {
+                size_t inicio = i;
+                for (++i; i < texto.size() && texto[i] != '"'; ++i)
+                    if (texto[i] == '\\') ++i;
+                if (i >= texto.size()) {
+                    posError = inicio;
+                    return false;
+                }
+            } else if (c == '{' || c == '[') {
+                if (c == '{' && profundidad == base) inicios.push_back(i);
+                ++profundidad;
+            } else if (c == '}' || c == ']') {
+                if (--profundidad < 0) {
+                    posError = i;
+                    return false;
+                }
+                if (profundidad == 0 && base == 1) {        // se cerro el arreglo: lo que sigue solo pueden ser espacios
+                    for (++i; i < texto.size() && isspace(static_cast<unsigned char>(texto[i])); ++i) {}
+                    if (i == texto.size()) return true;
+                    posError = i;
+                    motivo = "texto después del cierre del arreglo";
+                    return false;
+                }
+            }
+        }
+        // un cliente sin cerrar se reporta donde empieza; si solo falta el ']' final, al final del archivo
+        posError = (profundidad > base && !inicios.empty()) ? inicios.back() : texto.size();
+        return profundidad == 0;
+    }
+
+public:
+    /**
+     * @brief Mapea y lee un archivo de clientes. El formato se reconoce por el contenido: JSON si empieza con '[' o '{'
+     * 
+     * @param ruta Archivo CSV o JSON
+     * @param error Mensaje si falla (con el numero de linea)
+     * @param hilosLectores Hilos lectores; 0 = uno por nucleo con trozos de al menos 1 MiB (las pruebas fijan otro valor para
+     * partir archivos pequeños)
+     * @return true Si todos los clientes son validos
+     */
+    bool cargar(const std::string& ruta, std::string& error, size_t hilosLectores = 0) {
+        trozos.clear();
+        totalRegistros = 0;
+        if (!archivo.abrir(ruta, error)) return false;
+        std::string_view texto(archivo.data(), archivo.size());
+        if (texto.size() >= 3 && memcmp(texto.data(), "\xEF\xBB\xBF", 3) == 0) texto.remove_prefix(3);     // BOM de algunos editores
+        size_t primero = 0;
+        while (primero < texto.size() && isspace(static_cast<unsigned char>(texto[primero]))) ++primero;
+        bool json = primero < texto.size() && (texto[primero] == '[' || texto[primero] == '{');
+
+        size_t hilos = hilosLectores;
+        if (hilos == 0) {
+            hilos = std::max<size_t>(1, std::thread::hardware_concurrency());
+            hilos = std::min(hilos, std::max<size_t>(1, texto.size() >> 20));       // trozos de al menos 1 MiB
+        }
+        std::vector<std::string_view> partes;
+        if (json) {
+            std::vector<size_t> inicios;
+            size_t posError = 0;
+            const char* motivo = "";
+            if (!ubicarObjetos(texto, inicios, posError, motivo)) {
+                error = ruta + ":" + std::to_string(1 + std::count(texto.data(), texto.data() + posError, '\n')) + ": " + motivo;
+                return false;
+            }
+            hilos = std::max<size_t>(1, std::min(hilos, inicios.size()));
+            for (size_t k = 0; k < hilos && !inicios.empty(); ++k) {
+                size_t desde = inicios[inicios.size() * k / hilos];
+                size_t hasta = (k + 1 == hilos) ? texto.size() : inicios[inicios.size() * (k + 1) / hilos];
+                partes.push_back(texto.substr(desde, hasta - desde));
+            }
+        } else {
+            size_t inicio = 0;
+            for (size_t k = 0; k < hilos; ++k) {
+                size_t fin = (k + 1 == hilos) ? texto.size() : std::max(inicio, texto.size() * (k + 1) / hilos);
+                while (fin > 0 && fin < texto.size() && texto[fin - 1] != '\n') ++fin;       // cada trozo termina en un salto de linea
+                partes.push_back(texto.substr(inicio, fin - inicio));
+                inicio = fin;
+            }
+        }
+
+        trozos.resize(partes.size());
+        std::vector<std::thread> lectores;
+        for (size_t k = 0; k < partes.size(); ++k) {
+            lectores.emplace_back([json, k, parte = partes[k], &trozo = trozos[k]]() {
+                if (json) leerJson(parte, trozo);
+                else leerCsv(parte, trozo, k == 0);
+            });
+        }
+        for (std::thread& h : lectores) h.join();
+
+        for (const Trozo& t : trozos) {
+            if (t.posError != nullptr) {        // los trozos estan en orden: el primero con error es el primero del archivo
+                size_t linea = 1 + static_cast<size_t>(std::count(archivo.data(), t.posError, '\n'));
+                error = ruta + ":" + std::to_string(linea) + ": " + t.error;
+                trozos.clear();
+                totalRegistros = 0;     // un archivo con errores no importa a nadie, tampoco los trozos anteriores
+                return false;
+            }
+            if (t.productos.size() > std::numeric_limits<uint32_t>::max()) {
+                error = ruta + ": el archivo tiene demasiados productos";
+                trozos.clear();
+                totalRegistros = 0;
+                return false;
+            }
+            totalRegistros += t.registros.size();
+        }
+        return true;
+    }
+
+    size_t size() const { return totalRegistros; }      // cantidad de clientes
+
+    /**
+     * @brief Arma todos los clientes en el orden del archivo, listos para ColaPrioritariaD1::agregarClientes
+     * 
+     * @return vector<Cliente> Clientes con su carrito (el orden de llegada lo asigna la fila)
+     */
+    std::vector<Cliente> clientes() const {
+        std::vector<Cliente> lista;
+        lista.reserve(totalRegistros);
+        for (const Trozo& t : trozos) {
+            for (const Registro& r : t.registros) {
+                const IdProducto* productos = t.productos.data() + r.primerProducto;
+                CarritoDeCompras carrito(r.nombre, PilaProductos(productos, productos + r.cantidad));
+                lista.emplace_back(r.nombre, std::move(carrito), r.opcion == '1', r.opcion == '2', r.opcion == '3', 0);
+            }
+        }
+        return lista;
+    }
+};
+
+#endif
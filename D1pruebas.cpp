@@ -0,0 +1,401 @@
+/**
+ * @file D1pruebas.cpp
+ * @author Juan Bohorquez (jbohorquezsa@unal.edu.co)
+ * @author Julian Quintero (julquinteroca@unal.edu.co)
+ * @author Santiago Herrera (sanherrerapa@unal.edu.co)
+ *
+ * @brief Pruebas de comportamiento de los lectores de archivos del D1 (importacion de clientes, trazas de llegadas y
+ * diario de facturas). Usa
+ * solo los encabezados, sin el main interactivo. Cada prueba escribe un archivo pequeño, lo carga y comprueba cuantos
+ * clientes quedaron y en que linea se reporta el error. Termina con 1 si alguna comprobacion falla.
+ * Compilar con: g++ -std=c++17 -O2 -pthread D1pruebas.cpp -o D1pruebas
+ * @version 0.2
+ * @date 2025-10-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "D1importacion.h"
+#include "D1traza.h"
+#include "D1diario.h"
+#include "D1pruebas.h"
+
+using namespace std;
+
+/**
+ * @brief Numero de linea de un mensaje "ruta:linea: motivo"
+ *
+ * @param error Mensaje de error
+ * @param ruta Archivo que se cargo
+ * @return size_t Linea, o 0 si el mensaje no trae una
+ */
+size_t lineaDelError(const string& error, const string& ruta) {
+    if (error.compare(0, ruta.size() + 1, ruta + ":") != 0) return 0;
+    size_t linea = 0;
+    for (size_t i = ruta.size() + 1; i < error.size() && isdigit(static_cast<unsigned char>(error[i])); ++i)
+        linea = linea * 10 + static_cast<size_t>(error[i] - '0');
+    return linea;
+}
+
+/**
+ * @brief Productos del carrito de un cliente, del fondo al tope
+ *
+ */
+vector<string> productosDe(const Cliente& c) {
+    vector<string> nombres;
+    for (IdProducto id : c.carrito.verProductos()) nombres.push_back(catalogo().nombre(id));
+    return nombres;
+}
+
+/**
+ * @brief Resultado de importar un texto
+ *
+ */
+struct Importado {
+    bool correcto = false;
+    size_t cantidad = 0;        // lo que reporta size() despues de cargar
+    size_t lineaError = 0;
+    string error;
+    vector<Cliente> clientes;
+};
+
+Importado importar(const string& nombre, const string& contenido, size_t lectores = 1) {
+    ArchivoTemporal archivo(nombre, contenido);
+    ImportacionClientes importacion;
+    Importado r;
+    r.correcto = importacion.cargar(archivo.ruta(), r.error, lectores);
+    r.cantidad = importacion.size();
+    r.lineaError = lineaDelError(r.error, archivo.ruta());
+    if (r.correcto) r.clientes = importacion.clientes();
+    return r;
+}
+
+void pruebaCsvSinEncabezado() {
+    Importado r = importar("sin_encabezado.csv", "Ana,1,Pan|Leche\nLuis,4,\r\nMarta,3\n");
+    COMPROBAR(r.correcto);
+    COMPROBAR(r.cantidad == 3);
+    COMPROBAR(r.clientes.size() == 3);
+    if (r.clientes.size() != 3) return;
+    COMPROBAR(r.clientes[0].nombre == "Ana" && r.clientes[0].discapacidad);
+    COMPROBAR(productosDe(r.clientes[0]) == vector<string>({"Pan", "Leche"}));
+    COMPROBAR(r.clientes[1].nombre == "Luis" && !r.clientes[1].discapacidad && !r.clientes[1].adultoMayor && !r.clientes[1].embarazada);
+    COMPROBAR(r.clientes[1].carrito.empty());
+    COMPROBAR(r.clientes[2].nombre == "Marta" && r.clientes[2].embarazada);
+}
+
+void pruebaCsvEncabezado() {
+    Importado r = importar("encabezado.csv", "Nombre,Prioridad,Productos\nAna,2,Pan\n");
+    COMPROBAR(r.correcto);
+    COMPROBAR(r.cantidad == 1);
+    COMPROBAR(r.clientes.size() == 1 && r.clientes[0].nombre == "Ana" && r.clientes[0].adultoMayor);
+
+    r = importar("encabezado_cliente.csv", "  CLIENTE , prioridad\nAna,2,Pan\n");
+    COMPROBAR(r.correcto);
+    COMPROBAR(r.cantidad == 1);
+
+    // una primera linea que no se llama nombre/cliente es un cliente y se valida como tal
+    r = importar("sin_prioridad.csv", "Ana,,Pan\nLuis,2,Leche\n");
+    COMPROBAR(!r.correcto);
+    COMPROBAR(r.cantidad == 0);
+    COMPROBAR(r.lineaError == 1);
+
+    r = importar("prioridad_texto.csv", "Ana,alta,Pan\n");
+    COMPROBAR(!r.correcto);
+    COMPROBAR(r.lineaError == 1);
+
+    // el encabezado solo puede ser la primera linea
+    r = importar("encabezado_tarde.csv", "Ana,2,Pan\nNombre,Prioridad,Productos\n");
+    COMPROBAR(!r.correcto);
+    COMPROBAR(r.lineaError == 2);
+}
+
+void pruebaCsvComillas() {
+    Importado r = importar("comillas.csv",
+                           "\"Pérez, Ana\",2,\"Pan|\"\"Especial\"\" Leche\"\n"
+                           "  \"Luis\"  , 4 ,  Sal  \n");
+    COMPROBAR(r.correcto);
+    COMPROBAR(r.cantidad == 2);
+    if (r.clientes.size() == 2) {
+        COMPROBAR(r.clientes[0].nombre == "Pérez, Ana");
+        COMPROBAR(productosDe(r.clientes[0]) == vector<string>({"Pan", "\"Especial\" Leche"}));
+        COMPROBAR(r.clientes[1].nombre == "Luis");
+        COMPROBAR(productosDe(r.clientes[1]) == vector<string>({"Sal"}));
+    }
+
+    r = importar("texto_tras_comilla.csv", "Luis,2,Leche\n\"Ana\"x,2,Pan\n");
+    COMPROBAR(!r.correcto);
+    COMPROBAR(r.cantidad == 0);
+    COMPROBAR(r.lineaError == 2);
+
+    r = importar("comilla_abierta.csv", "Luis,2,Leche\nAna,2,Pan\n\"Marta,3,Sal\n");
+    COMPROBAR(!r.correcto);
+    COMPROBAR(r.lineaError == 3);
+}
+
+void pruebaCsvValoresInvalidos() {
+    const char* invalidas[] = {"Ana,0,Pan", "Ana,5,Pan", "Ana,12,Pan", "Ana,-1,Pan", ",2,Pan", "Ana", "Ana,2,Pan,sobra"};
+    for (const char* linea : invalidas) {
+        Importado r = importar("invalida.csv", string("Luis,1,Leche\n\nMarta,3,Sal\n") + linea + "\nPedro,4,Pan\n");
+        COMPROBAR(!r.correcto);
+        COMPROBAR(r.cantidad == 0);
+        COMPROBAR(r.lineaError == 4);       // la linea vacia tambien cuenta
+        if (r.lineaError != 4) cerr << "  linea: " << linea << " -> " << r.error << "\n";
+    }
+}
+
+void pruebaCsvDeshacer() {
+    Importado r = importar("deshacer.csv", "Ana,4,borrar|Pan|BORRAR|Leche|Deshacer|Sal|Arroz|eliminar\n");
+    COMPROBAR(r.correcto);
+    COMPROBAR(r.clientes.size() == 1 && productosDe(r.clientes[0]) == vector<string>({"Sal"}));
+}
+
+void pruebaCsvTrozos() {
+    // lineas largas: con varios lectores los cortes caen a mitad de linea y cada trozo debe correrse al siguiente salto
+    const size_t total = 997;
+    string texto = "nombre,prioridad,productos\n";
+    for (size_t i = 0; i < total; ++i) {
+        texto += "Cliente " + to_string(i) + "," + to_string(1 + i % 4) + ",";
+        for (size_t p = 0; p <= i % 7; ++p) texto += (p ? "|" : "") + string("Producto de prueba numero ") + to_string(p);
+        texto += "\n";
+    }
+    for (size_t lectores : {2, 3, 8, 64}) {
+        Importado r = importar("trozos.csv", texto, lectores);
+        COMPROBAR(r.correcto);
+        COMPROBAR(r.cantidad == total);
+        bool enOrden = r.clientes.size() == total;
+        for (size_t i = 0; enOrden && i < total; ++i)
+            enOrden = string_view(r.clientes[i].nombre) == "Cliente " + to_string(i) && r.clientes[i].carrito.size() == i % 7 + 1;
+        COMPROBAR(enOrden);
+    }
+
+    // el error de un trozo posterior se reporta con la linea del archivo completo
+    string conError = texto;
+    size_t linea500 = 0;
+    for (int i = 0; i < 499; ++i) linea500 = conError.find('\n', linea500) + 1;
+    conError.insert(linea500, "Roto,9,Pan\n");
+    Importado r = importar("trozos_error.csv", conError, 4);
+    COMPROBAR(!r.correcto);
+    COMPROBAR(r.cantidad == 0);
+    COMPROBAR(r.lineaError == 500);
+}
+
+void pruebaJson() {
+    Importado r = importar("clientes.json",
+                           "[\n"
+                           "  {\"nombre\": \"Ana \\\"la\\\" \\u00c1guila\", \"prioridad\": 1, \"productos\": [\"Pan\", \"Leche\"]},\n"
+                           "  {\"nombre\": \"Luis\", \"prioridad\": \"3\", \"edad\": 40},\n"
+                           "  {\"prioridad\": 4, \"nombre\": \"Marta\", \"productos\": [\"Sal\", \"DESHACER\", \"Arroz\"]}\n"
+                           "]\n");
+    COMPROBAR(r.correcto);
+    COMPROBAR(r.cantidad == 3);
+    if (r.clientes.size() == 3) {
+        COMPROBAR(r.clientes[0].nombre == "Ana \"la\" \xC3\x81guila" && r.clientes[0].discapacidad);
+        COMPROBAR(productosDe(r.clientes[0]) == vector<string>({"Pan", "Leche"}));
+        COMPROBAR(r.clientes[1].nombre == "Luis" && r.clientes[1].embarazada && r.clientes[1].carrito.empty());
+        COMPROBAR(productosDe(r.clientes[2]) == vector<string>({"Arroz"}));
+    }
+
+    r = importar("por_linea.json", "{\"nombre\": \"Ana\", \"prioridad\": 2}\n{\"nombre\": \"Luis\", \"prioridad\": 4}\n", 2);
+    COMPROBAR(r.correcto);
+    COMPROBAR(r.cantidad == 2);
+
+    r = importar("sin_dos_puntos.json",
+                 "[\n  {\"nombre\": \"Ana\", \"prioridad\": 1},\n  {\"nombre\" \"Luis\", \"prioridad\": 2}\n]\n");
+    COMPROBAR(!r.correcto);
+    COMPROBAR(r.cantidad == 0);
+    COMPROBAR(r.lineaError == 3);
+
+    r = importar("sin_cerrar.json", "[\n  {\"nombre\": \"Ana\", \"prioridad\": 1},\n  {\"nombre\": \"Luis\", \"prioridad\": 2\n");
+    COMPROBAR(!r.correcto);
+    COMPROBAR(r.cantidad == 0);
+    COMPROBAR(r.lineaError == 3);       // donde empieza el cliente que quedo abierto
+
+    r = importar("sin_corchete.json", "[\n  {\"nombre\": \"Ana\", \"prioridad\": 1},\n  {\"nombre\": \"Luis\", \"prioridad\": 2}\n");
+    COMPROBAR(!r.correcto);
+    COMPROBAR(r.cantidad == 0);
+    COMPROBAR(r.lineaError == 4);       // solo falta el ']': se reporta el final del archivo
+
+    // despues del ']' final solo se aceptan espacios; cualquier otro texto es un error en su linea
+    r = importar("espacios_finales.json", "[\n  {\"nombre\": \"Ana\", \"prioridad\": 1}\n]\n  \n\t\n");
+    COMPROBAR(r.correcto);
+    COMPROBAR(r.cantidad == 1);
+    const char* sobrantes[] = {"x", "{\"nombre\": \"Luis\", \"prioridad\": 2}", "[]", ",", "\"Luis\""};
+    for (const char* sobrante : sobrantes) {
+        r = importar("texto_final.json", string("[\n  {\"nombre\": \"Ana\", \"prioridad\": 1}\n]\n\n") + sobrante + "\n", 2);
+        COMPROBAR(!r.correcto);
+        COMPROBAR(r.cantidad == 0);
+        COMPROBAR(r.lineaError == 5);
+        if (r.lineaError != 5) cerr << "  sobrante: '" << sobrante << "' -> " << r.error << "\n";
+    }
+
+    r = importar("prioridad_json.json", "[\n  {\"nombre\": \"Ana\", \"prioridad\": 1},\n\n  {\"nombre\": \"Luis\", \"prioridad\": 7}\n]\n", 2);
+    COMPROBAR(!r.correcto);
+    COMPROBAR(r.cantidad == 0);
+    COMPROBAR(r.lineaError == 4);
+}
+
+/**
+ * @brief Resultado de cargar una traza
+ *
+ */
+struct Trazado {
+    bool correcto = false;
+    size_t cantidad = 0;
+    size_t lineaError = 0;
+    string error;
+    vector<pair<string, int64_t>> llegadas;     // (nombre, llegada en µs) en el orden en que entran a la fila
+    vector<Cliente> clientes;
+};
+
+Trazado cargarTraza(const string& nombre, const string& contenido, size_t lectores = 1) {
+    ArchivoTemporal archivo(nombre, contenido);
+    TrazaLlegadas traza;
+    Trazado r;
+    r.correcto = traza.cargar(archivo.ruta(), r.error, lectores);
+    r.cantidad = traza.size();
+    r.lineaError = lineaDelError(r.error, archivo.ruta());
+    for (size_t i = 0; i < traza.size(); ++i) {
+        r.clientes.push_back(traza.cliente(i));
+        r.llegadas.emplace_back(string(r.clientes.back().nombre), traza.llegadaUs(i));
+    }
+    return r;
+}
+
+void pruebaTrazaSinSaltoFinal() {
+    Trazado r = cargarTraza("sin_salto.txt", "# nombre;prioridad;productos;llegada_us\nAna;1;Pan|Leche;10\r\nLuis;4;;20");
+    COMPROBAR(r.correcto);
+    COMPROBAR(r.cantidad == 2);
+    COMPROBAR(r.llegadas == (vector<pair<string, int64_t>>{{"Ana", 10}, {"Luis", 20}}));
+    if (r.clientes.size() == 2) {
+        COMPROBAR(r.clientes[0].discapacidad && productosDe(r.clientes[0]) == vector<string>({"Pan", "Leche"}));
+        COMPROBAR(r.clientes[1].carrito.empty());
+    }
+
+    // sin llegada el cliente llega junto con el anterior; una ultima linea cortada a mitad de un producto sigue siendo valida
+    r = cargarTraza("sin_llegada.txt", "Ana;2;Pan;15\nLuis;3;Sal\nMarta;4;Pan|Le", 2);
+    COMPROBAR(r.correcto);
+    COMPROBAR(r.llegadas == (vector<pair<string, int64_t>>{{"Ana", 15}, {"Luis", 15}, {"Marta", 15}}));
+    COMPROBAR(r.clientes.size() == 3 && productosDe(r.clientes[2]) == vector<string>({"Pan", "Le"}));
+}
+
+void pruebaTrazaLineasTruncadas() {
+    const char* truncadas[] = {"Marta", "Marta;", "Marta;3", ";3;Pan;30", "Marta;3;Pan;3x", "Marta;3;Pan;-30", "Marta;3;Pan;30;sobra"};
+    for (const char* linea : truncadas) {
+        for (const char* fin : {"\n", ""}) {       // en medio del archivo y como ultima linea sin salto
+            string texto = string("Ana;1;Pan;10\n# comentario\n\nLuis;2;Sal;20\n") + linea + fin;
+            if (*fin) texto += "Pedro;4;Pan;40\n";
+            Trazado r = cargarTraza("truncada.txt", texto);
+            COMPROBAR(!r.correcto);
+            COMPROBAR(r.cantidad == 0);
+            COMPROBAR(r.lineaError == 5);       // comentarios y lineas vacias tambien cuentan
+            if (r.lineaError != 5) cerr << "  linea: " << linea << " -> " << r.error << "\n";
+        }
+    }
+}
+
+void pruebaTrazaDesordenada() {
+    Trazado r = cargarTraza("desordenada.txt", "A;4;Pan;30\nB;4;Pan;10\nC;4;Pan\nD;4;Pan;20\nE;4;Pan;10\n");
+    COMPROBAR(r.correcto);
+    // se ordena por llegada y los empates conservan el orden del archivo (C hereda la llegada de B)
+    COMPROBAR(r.llegadas == (vector<pair<string, int64_t>>{{"B", 10}, {"C", 10}, {"E", 10}, {"D", 20}, {"A", 30}}));
+
+    // con varios lectores: los clientes sin llegada heredan la del anterior aunque este haya quedado en otro trozo
+    string texto;
+    for (int i = 0; i < 600; ++i) {
+        texto += "Cliente " + to_string(i) + ";" + to_string(1 + i % 4) + ";Producto de prueba con nombre largo";
+        if (i % 3 != 2) texto += ";" + to_string((i * 7919) % 1000);
+        texto += "\n";
+    }
+    Trazado uno = cargarTraza("desordenada_larga.txt", texto, 1);
+    COMPROBAR(uno.correcto && uno.cantidad == 600);
+    bool ordenada = true;
+    for (size_t i = 1; i < uno.llegadas.size(); ++i) ordenada = ordenada && uno.llegadas[i - 1].second <= uno.llegadas[i].second;
+    COMPROBAR(ordenada);
+    for (size_t lectores : {2, 5, 16}) {
+        Trazado varios = cargarTraza("desordenada_larga.txt", texto, lectores);
+        COMPROBAR(varios.correcto);
+        COMPROBAR(varios.llegadas == uno.llegadas);
+    }
+}
+
+void pruebaTrazaPrioridades() {
+    Trazado r = cargarTraza("prioridades.txt", "A;1;;1\nB;2;;2\nC;3;;3\nD;4;;4\n");
+    COMPROBAR(r.correcto);
+    if (r.clientes.size() == 4) {
+        COMPROBAR(r.clientes[0].discapacidad && !r.clientes[0].adultoMayor && !r.clientes[0].embarazada);
+        COMPROBAR(r.clientes[1].adultoMayor && !r.clientes[1].discapacidad && !r.clientes[1].embarazada);
+        COMPROBAR(r.clientes[2].embarazada && !r.clientes[2].discapacidad && !r.clientes[2].adultoMayor);
+        COMPROBAR(!r.clientes[3].discapacidad && !r.clientes[3].adultoMayor && !r.clientes[3].embarazada);
+    }
+
+    const char* invalidas[] = {"0", "5", "12", "a", "", " 1", "1 ", "-1"};
+    for (const char* prioridad : invalidas) {
+        Trazado mala = cargarTraza("prioridad_invalida.txt", string("A;1;Pan;1\nB;") + prioridad + ";Pan;2\nC;4;Pan;3\n", 2);
+        COMPROBAR(!mala.correcto);
+        COMPROBAR(mala.cantidad == 0);
+        COMPROBAR(mala.lineaError == 2);
+        if (mala.lineaError != 2) cerr << "  prioridad: '" << prioridad << "' -> " << mala.error << "\n";
+    }
+}
+
+/**
+ * @brief Registro 'P' del diario con un identificador y un nombre
+ *
+ */
+string registroProducto(uint32_t id, const string& nombre) {
+    string r;
+    uint32_t largo = static_cast<uint32_t>(1 + 4 + 2 + nombre.size());
+    uint16_t largoNombre = static_cast<uint16_t>(nombre.size());
+    r.append(reinterpret_cast<const char*>(&largo), 4);
+    r += 'P';
+    r.append(reinterpret_cast<const char*>(&id), 4);
+    r.append(reinterpret_cast<const char*>(&largoNombre), 2);
+    return r + nombre;
+}
+
+void pruebaDiarioIdProducto() {
+    string cabecera(MAGIA_DIARIO, 4);
+    cabecera.append(reinterpret_cast<const char*>(&VERSION_DIARIO), 4);
+
+    ArchivoTemporal sano("diario_sano.d1j", cabecera + registroProducto(3, "Pan") + registroProducto(MAX_PRODUCTOS_DIARIO - 1, "Leche"));
+    LectorDiario lector;
+    string error;
+    COMPROBAR(lector.abrir(sano.ruta(), error));
+    COMPROBAR(lector.recorrer([](const FacturaLeida&) {}, error));
+    COMPROBAR(lector.nombreProducto(3) == "Pan" && lector.nombreProducto(MAX_PRODUCTOS_DIARIO - 1) == "Leche");
+
+    // un identificador dañado (por ejemplo 0xFFFFFFF0) se rechaza en lugar de reservar memoria para todos los anteriores
+    ArchivoTemporal danado("diario_id.d1j", cabecera + registroProducto(3, "Pan") + registroProducto(0xFFFFFFF0u, "Leche"));
+    LectorDiario otro;
+    error.clear();
+    COMPROBAR(otro.abrir(danado.ruta(), error));
+    COMPROBAR(!otro.recorrer([](const FacturaLeida&) {}, error));
+    COMPROBAR(error == "Producto dañado en el diario");
+}
+
+void pruebaDiarioEscrituraFallida() {
+    ifstream existe("/dev/full");
+    if (!existe) return;        // solo donde hay un dispositivo que siempre esta lleno
+    DiarioFacturas diario;
+    string error;
+    COMPROBAR(diario.abrir("/dev/full", error));
+    diario.cerrar();
+    COMPROBAR(!diario.getErrorEscritura().empty());
+}
+
+int main() {
+    correr("importacion: csv sin encabezado", pruebaCsvSinEncabezado);
+    correr("importacion: csv con encabezado", pruebaCsvEncabezado);
+    correr("importacion: csv con comillas", pruebaCsvComillas);
+    correr("importacion: csv con prioridad o campos invalidos", pruebaCsvValoresInvalidos);
+    correr("importacion: palabras de deshacer", pruebaCsvDeshacer);
+    correr("importacion: csv partido en trozos", pruebaCsvTrozos);
+    correr("importacion: json", pruebaJson);
+    correr("traza: ultima linea sin salto", pruebaTrazaSinSaltoFinal);
+    correr("traza: lineas truncadas", pruebaTrazaLineasTruncadas);
+    correr("traza: llegadas desordenadas", pruebaTrazaDesordenada);
+    correr("traza: prioridades", pruebaTrazaPrioridades);
+    correr("diario: identificador de producto fuera de rango", pruebaDiarioIdProducto);
+    correr("diario: escritura fallida", pruebaDiarioEscrituraFallida);
+    return terminarPruebas();
+}
@@ -0,0 +1,80 @@
+/**
+ * @file D1pruebas.h
+ * @author Juan Bohorquez (jbohorquezsa@unal.edu.co)
+ * @author Julian Quintero (julquinteroca@unal.edu.co)
+ * @author Santiago Herrera (sanherrerapa@unal.edu.co)
+ *
+ * @brief Lo minimo para escribir pruebas: COMPROBAR, archivos temporales y el resumen de la corrida. Lo usan
+ * D1pruebas.cpp y D1pruebasPuntoControl.cpp
+ * @version 0.2
+ * @date 2025-10-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef D1_PRUEBAS_H
+#define D1_PRUEBAS_H
+
+#include <fstream>   // Archivos temporales de cada prueba
+
+#include "D1comun.h"
+
+/**
+ * @brief Contadores de la corrida de pruebas
+ *
+ */
+inline int comprobaciones = 0;
+inline int fallas = 0;
+inline const char* pruebaActual = "";
+
+inline void comprobar(bool correcto, const char* condicion, const char* archivo, int linea) {
+    ++comprobaciones;
+    if (correcto) return;
+    ++fallas;
+    std::cerr << ANS_RED << "FALLA " << pruebaActual << " (" << archivo << ":" << linea << "): " << condicion << ANS_RESET << "\n";
+}
+
+#define COMPROBAR(condicion) comprobar((condicion), #condicion, __FILE__, __LINE__)
+
+/**
+ * @brief Archivo que existe mientras dura la prueba
+ *
+ */
+class ArchivoTemporal {
+private:
+    std::string ruta_;
+
+public:
+    ArchivoTemporal(const std::string& nombre, const std::string& contenido) : ruta_("d1pruebas_" + nombre) {
+        std::ofstream archivo(ruta_, std::ios::binary);
+        archivo << contenido;
+    }
+    ArchivoTemporal(const ArchivoTemporal&) = delete;
+    ArchivoTemporal& operator=(const ArchivoTemporal&) = delete;
+    ~ArchivoTemporal() { remove(ruta_.c_str()); }
+
+    const std::string& ruta() const { return ruta_; }
+};
+
+/**
+ * @brief Corre una prueba con su nombre
+ *
+ */
+inline void correr(const char* nombre, void (*prueba)()) {
+    pruebaActual = nombre;
+    int antes = fallas;
+    prueba();
+    std::cout << (fallas == antes ? ANS_GREEN + "ok    " : ANS_RED + "FALLA ") << ANS_RESET << nombre << "\n";
+}
+
+/**
+ * @brief Muestra el resumen de la corrida
+ *
+ * @return int Codigo de salida del programa de pruebas: 1 si alguna comprobacion fallo
+ */
+inline int terminarPruebas() {
+    std::cout << comprobaciones << " comprobaciones, " << fallas << " fallas\n";
+    return fallas == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,402 @@
+/**
+ * @file D1pruebasPuntoControl.cpp
+ * @author Juan Bohorquez (jbohorquezsa@unal.edu.co)
+ * @author Julian Quintero (julquinteroca@unal.edu.co)
+ * @author Santiago Herrera (sanherrerapa@unal.edu.co)
+ *
+ * @brief Pruebas de los puntos de control: una foto tomada con la fila cambiando debe guardar la fila tal como estaba en
+ * T0, y una atencion retomada desde una foto tomada a mitad de la corrida debe cobrar lo mismo, en el mismo orden, que
+ * la corrida sin interrumpir, con los dos almacenes de la fila. Con terminales abiertas la foto no pierde a los clientes
+ * que ya tienen turno. Reutiliza las clases de D1actualizado1.cpp sin su main.
+ * Compilar con: g++ -std=c++17 -O2 -pthread D1pruebasPuntoControl.cpp -o D1pruebasPuntoControl
+ * @version 0.2
+ * @date 2025-10-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#define D1_SIN_MAIN
+#include "D1actualizado1.cpp"
+#include "D1pruebas.h"
+
+/**
+ * @brief Clientes fijos para las pruebas: de los tres tipos de atencion especial, con carritos de 0 a 8 productos
+ *
+ * @param n Cantidad de clientes
+ * @param primero Orden de llegada del primero
+ * @return vector<Cliente> Clientes con su orden de llegada asignado
+ */
+vector<Cliente> clientesDePrueba(size_t n, int primero = 0) {
+    vector<IdProducto> productos;
+    for (const auto& estante : ESTANTES)
+        for (const auto& articulo : estante) productos.push_back(catalogo().registrar(articulo.first));
+    vector<Cliente> lista;
+    lista.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        int orden = primero + static_cast<int>(i);
+        string nombre = "Cliente " + to_string(orden);
+        CarritoDeCompras carrito(nombre);
+        for (size_t p = 0; p < static_cast<size_t>(orden) * 7 % 9; ++p) carrito.push(productos[(orden + p * 5) % productos.size()]);
+        Cliente c(nombre, move(carrito), orden % 11 == 0, orden % 13 == 0, orden % 17 == 0, orden);
+        c.llegadaNs = ahoraNs();
+        lista.push_back(move(c));
+    }
+    return lista;
+}
+
+/**
+ * @brief Si un cliente restaurado es igual al original (nombre, banderas, orden de llegada y carrito)
+ *
+ */
+bool mismoCliente(const Cliente& a, const Cliente& b) {
+    VistaProductos pa = a.carrito.verProductos(), pb = b.carrito.verProductos();
+    return a.nombre == b.nombre && a.ordenLlegada == b.ordenLlegada && a.discapacidad == b.discapacidad &&
+           a.adultoMayor == b.adultoMayor && a.embarazada == b.embarazada && equal(pa.begin(), pa.end(), pb.begin(), pb.end());
+}
+
+/**
+ * @brief Clientes del punto de control ordenados por llegada, para compararlos con los originales
+ *
+ */
+vector<Cliente> leerClientes(const string& ruta, EstadoPuntoDeControl& estado) {
+    string error;
+    COMPROBAR(PuntoDeControl::leer(ruta, estado, error));
+    if (!error.empty()) cerr << "  " << error << "\n";
+    vector<Cliente> clientes = move(estado.clientes);
+    sort(clientes.begin(), clientes.end(), [](const Cliente& a, const Cliente& b) { return a.ordenLlegada < b.ordenLlegada; });
+    return clientes;
+}
+
+void pruebaFotoConCopiaAlEscribir() {
+    const size_t total = 3000;
+    ArchivoTemporal archivo("cow.d1pc", "");
+    HeapIndexado<> fila;
+    vector<ManejadorCliente> manejadores;
+    for (Cliente& c : clientesDePrueba(total)) manejadores.push_back(fila.push(move(c)));
+
+    string error;
+    PuntoDeControl foto;
+    COMPROBAR(foto.abrir(archivo.ruta(), error));
+    foto.cabecera(static_cast<uint32_t>(total), 1, fila.size(), 0, 0);
+    fila.iniciarFoto(foto);
+
+    // con la foto en curso la fila sigue cambiando: se atiende, se van clientes y llegan otros a las ranuras libres
+    size_t atendidos = 0, retirados = 0;
+    for (; atendidos < 500; ++atendidos) {
+        Cliente c = move(fila.top());
+        fila.pop();
+    }
+    for (size_t j = 0; j < 200; ++j)
+        if (fila.remove(manejadores[j * 13 % total])) ++retirados;
+    vector<Cliente> nuevos = clientesDePrueba(300, static_cast<int>(total));
+    for (Cliente& c : nuevos) fila.push(move(c));
+    while (!fila.copiarFoto(64)) {      // el hilo de la foto copia por trozos y entre trozo y trozo la caja atiende
+        Cliente c = move(fila.top());
+        fila.pop();
+        ++atendidos;
+    }
+    COMPROBAR(foto.cerrar(archivo.ruta(), error));
+    COMPROBAR(fila.size() == total - atendidos - retirados + 300);
+
+    EstadoPuntoDeControl estado;
+    vector<Cliente> guardados = leerClientes(archivo.ruta(), estado);
+    vector<Cliente> originales = clientesDePrueba(total);
+    COMPROBAR(guardados.size() == total);       // exactamente la fila de T0: ni los que salieron ni los que llegaron despues
+    bool iguales = guardados.size() == total;
+    for (size_t i = 0; iguales && i < total; ++i) iguales = mismoCliente(guardados[i], originales[i]);
+    COMPROBAR(iguales);
+}
+
+void pruebaFotoPorNiveles() {
+    const size_t total = 3000;
+    ArchivoTemporal archivo("niveles.d1pc", "");
+    ColaPorNiveles<> fila;
+    for (Cliente& c : clientesDePrueba(total)) fila.push(move(c));
+
+    string error;
+    PuntoDeControl foto;
+    COMPROBAR(foto.abrir(archivo.ruta(), error));
+    foto.cabecera(static_cast<uint32_t>(total), 1, fila.size(), 0, 0);
+    fila.iniciarFoto(foto);
+
+    // sin manejadores solo se atiende y llegan otros; los nuevos quedan detras de los de T0 en cada nivel
+    size_t atendidos = 0;
+    for (; atendidos < 500; ++atendidos) {
+        Cliente c = move(fila.top());
+        fila.pop();
+    }
+    vector<Cliente> nuevos = clientesDePrueba(300, static_cast<int>(total));
+    for (Cliente& c : nuevos) fila.push(move(c));
+    while (!fila.copiarFoto(64)) {
+        Cliente c = move(fila.top());
+        fila.pop();
+        ++atendidos;
+    }
+    COMPROBAR(foto.cerrar(archivo.ruta(), error));
+    COMPROBAR(fila.size() == total - atendidos + 300);
+
+    EstadoPuntoDeControl estado;
+    vector<Cliente> guardados = leerClientes(archivo.ruta(), estado);
+    vector<Cliente> originales = clientesDePrueba(total);
+    COMPROBAR(guardados.size() == total);
+    bool iguales = guardados.size() == total;
+    for (size_t i = 0; iguales && i < total; ++i) iguales = mismoCliente(guardados[i], originales[i]);
+    COMPROBAR(iguales);
+}
+
+/**
+ * @brief Con envejecimiento los dos almacenes deben atender en el mismo orden (llegadas espaciadas y en orden)
+ *
+ */
+void pruebaEnvejecimientoAlmacenes() {
+    const size_t total = 5000;
+    const int64_t nsPorNivel = 40000000;        // 40 ms por nivel
+    ColaPorNiveles<> niveles;
+    HeapIndexado<> heap;
+    niveles.fijarEnvejecimiento(nsPorNivel);
+    heap.fijarEnvejecimiento(nsPorNivel);
+    vector<Cliente> clientes = clientesDePrueba(total);
+    for (size_t i = 0; i < total; ++i) {
+        clientes[i].llegadaNs = static_cast<int64_t>(i) * 250000 + (i % 7) * 1000;      // una llegada cada 0.25 ms
+        niveles.push(clientes[i]);
+        heap.push(move(clientes[i]));
+    }
+    bool igual = true;
+    while (igual && !heap.empty()) {
+        igual = !niveles.empty() && niveles.top().ordenLlegada == heap.top().ordenLlegada;
+        niveles.pop();
+        heap.pop();
+    }
+    COMPROBAR(igual && niveles.empty());
+}
+
+/**
+ * @brief Salida que detiene a la caja cuando empieza a atender al cliente numero 'en', hasta que la prueba la suelte.
+ * Asi el punto de control se pide con la fila a medias y con la caja en pleno cobro
+ *
+ */
+class SalidaQueDetiene : public SalidaConsola {
+private:
+    size_t en;
+    size_t vistos = 0;
+
+public:
+    atomic<bool> detenida{false};
+    atomic<bool> seguir{false};
+
+    explicit SalidaQueDetiene(size_t cliente) : en(cliente) {}
+
+    void escribir(const char* datos, size_t n) override {
+        if (string_view(datos, n) != "Atendiendo a " || ++vistos != en) return;
+        detenida.store(true);
+        while (!seguir.load()) this_thread::yield();
+    }
+};
+
+/**
+ * @brief Atiende con una caja a los clientes que haya en la fila y devuelve las facturas en el orden en que se cobraron
+ *
+ */
+template <class Fila>
+vector<pair<string, int>> atenderYFacturar(Fila& fila) {
+    LatenciasPorNivel latencias;        // se acumulan aqui para no imprimir las tablas
+    fila.atenderClientes(1, &latencias);
+    vector<pair<string, int>> facturas;
+    for (const Factura& f : colaFacturas) facturas.emplace_back(string(f.nombreCliente), f.total);
+    colaFacturas.clear();
+    return facturas;
+}
+
+long long sumar(const vector<pair<string, int>>& facturas, size_t desde = 0) {
+    long long total = 0;
+    for (size_t i = desde; i < facturas.size(); ++i) total += facturas[i].second;
+    return total;
+}
+
+template <template <class> class Almacen>
+void pruebaRetomarAMitadDeCorrida() {
+    const size_t total = 4000, detenerEn = 1500;
+    const uint64_t semilla = 20251020;
+    opciones.headless = true;       // sin pausas de presentacion
+    motorPrecios.fijarSemilla(semilla);
+    colaFacturas.clear();
+
+    // corrida sin interrumpir
+    vector<pair<string, int>> esperadas;
+    {
+        ColaPrioritariaD1<PoliticaPorDefecto, Almacen> fila;
+        fila.agregarClientes(clientesDePrueba(total));
+        esperadas = atenderYFacturar(fila);
+    }
+    COMPROBAR(esperadas.size() == total);
+
+    // la misma corrida con un punto de control pedido mientras la caja cobra al cliente 'detenerEn'
+    ArchivoTemporal archivo("mitad.d1pc", "");
+    ArchivoTemporal archivoFacturas("mitad.d1pc.f1", "");
+    SalidaQueDetiene* detiene = new SalidaQueDetiene(detenerEn);
+    salidaGlobal.reset(detiene);
+    vector<pair<string, int>> interrumpida;
+    bool guardado = false;
+    {
+        ColaPrioritariaD1<PoliticaPorDefecto, Almacen> fila;
+        fila.agregarClientes(clientesDePrueba(total));
+        thread atencion([&]() { interrumpida = atenderYFacturar(fila); });
+        while (!detiene->detenida.load()) this_thread::yield();
+        thread soltar([&]() {       // la caja sigue un poco despues: el punto de control ya pidio la foto y espera su cobro
+            this_thread::sleep_for(chrono::milliseconds(20));
+            detiene->seguir.store(true);
+        });
+        string error;
+        guardado = fila.guardarPuntoDeControl(archivo.ruta(), error);
+        if (!guardado) cerr << "  " << error << "\n";
+        soltar.join();
+        atencion.join();
+    }
+    salidaGlobal.reset(new SalidaNula());
+    COMPROBAR(guardado);
+    COMPROBAR(interrumpida == esperadas);       // tomar la foto no cambia lo que se cobra
+
+    // contenido de la foto: las facturas ya cobradas y los clientes que seguian esperando, sin perder ni repetir a nadie
+    EstadoPuntoDeControl estado;
+    vector<Cliente> esperando = leerClientes(archivo.ruta(), estado);
+    size_t cobradas = estado.facturas.size();
+    COMPROBAR(cobradas >= detenerEn && cobradas < total);       // el cliente que se estaba cobrando termina antes de T0
+    COMPROBAR(esperando.size() + cobradas == total);
+    COMPROBAR(estado.contadorLlegadas == total && estado.semilla == semilla);
+    bool prefijo = cobradas <= esperadas.size();
+    for (size_t i = 0; prefijo && i < cobradas; ++i)
+        prefijo = string_view(estado.facturas[i].nombreCliente) == esperadas[i].first && estado.facturas[i].total == esperadas[i].second;
+    COMPROBAR(prefijo);
+    vector<Cliente> originales = clientesDePrueba(total);
+    vector<bool> cobrado(total, false);
+    for (size_t i = 0; i < cobradas && i < esperadas.size(); ++i) cobrado[stoul(esperadas[i].first.substr(8))] = true;
+    bool filaIgual = true;
+    size_t k = 0;
+    for (size_t i = 0; filaIgual && i < total; ++i) {
+        if (cobrado[i]) continue;
+        filaIgual = k < esperando.size() && mismoCliente(esperando[k], originales[i]);
+        ++k;
+    }
+    COMPROBAR(filaIgual && k == esperando.size());
+
+    // retomar desde la foto: se cobra el resto en el mismo orden y el total coincide con la corrida sin interrumpir
+    motorPrecios.fijarSemilla(estado.semilla);      // como hace --restaurar
+    for (Factura& f : estado.facturas) registrarFactura(move(f));
+    vector<pair<string, int>> retomada;
+    {
+        ColaPrioritariaD1<PoliticaPorDefecto, Almacen> fila;
+        fila.restaurar(move(esperando), static_cast<int>(estado.contadorLlegadas));
+        retomada = atenderYFacturar(fila);
+    }
+    COMPROBAR(retomada == esperadas);
+    COMPROBAR(sumar(retomada) == sumar(esperadas));
+}
+
+void pruebaFotoConTerminalesAbiertas() {
+    const size_t porTerminal = 20000;
+    const int numTerminales = 3;
+    opciones.headless = true;
+    colaFacturas.clear();
+    ArchivoTemporal archivo("terminales.d1pc", "");
+    ArchivoTemporal archivoFacturas("terminales.d1pc.f1", "");
+    ColaPrioritariaD1<> fila;
+    vector<Cliente> clientes = clientesDePrueba(porTerminal * numTerminales);
+    fila.abrirLlegadas(numTerminales);
+    atomic<int> activas{numTerminales};
+    vector<thread> terminales;
+    for (int t = 0; t < numTerminales; ++t)
+        terminales.emplace_back([&, t]() {
+            for (size_t i = t; i < clientes.size(); i += numTerminales) fila.recibirLlegada(move(clientes[i]));
+            --activas;
+        });
+
+    // sin cajas el anillo se llena y las terminales esperan con el turno ya tomado; solo los puntos de control lo vacian.
+    // Cada foto debe tener a todos los que ya tienen turno, ninguno perdido entre el turno y el anillo
+    bool completas = true;
+    size_t fotos = 0;
+    while (activas.load() > 0 && completas) {
+        string error;
+        completas = fila.guardarPuntoDeControl(archivo.ruta(), error);
+        if (!completas) cerr << "  " << error << "\n";
+        EstadoPuntoDeControl estado;
+        size_t esperando = leerClientes(archivo.ruta(), estado).size();
+        completas = completas && esperando == estado.contadorLlegadas;
+        ++fotos;
+    }
+    for (thread& h : terminales) h.join();
+    fila.cerrarLlegadas();
+    LatenciasPorNivel latencias;
+    fila.atenderClientes(2, &latencias);
+    COMPROBAR(completas && fotos > 1);
+    COMPROBAR(colaFacturas.size() == porTerminal * numTerminales);
+    colaFacturas.clear();
+}
+
+/**
+ * @brief Factura de prueba con un producto del catalogo
+ *
+ */
+Factura facturaDePrueba(size_t i) {
+    ProductosFactura prods;
+    prods.emplace_back(catalogo().registrar("Producto " + to_string(i % 7)), static_cast<int>(i % 90 + 10));
+    return Factura("Factura " + to_string(i), move(prods), static_cast<int>(i % 90 + 10), static_cast<int64_t>(i));
+}
+
+/**
+ * @brief Facturas del punto de control iguales a las de prueba [0, n)
+ *
+ */
+bool mismasFacturas(const EstadoPuntoDeControl& estado, size_t n) {
+    bool iguales = estado.facturas.size() == n;
+    for (size_t i = 0; iguales && i < n; ++i) {
+        Factura f = facturaDePrueba(i);
+        iguales = estado.facturas[i].nombreCliente == f.nombreCliente && estado.facturas[i].total == f.total &&
+                  estado.facturas[i].instanteNs == f.instanteNs && estado.facturas[i].productos == f.productos;
+    }
+    return iguales;
+}
+
+void pruebaFacturasIncrementales() {
+    colaFacturas.clear();
+    ArchivoTemporal archivo("incremental.d1pc", "");
+    ArchivoTemporal generacion1("incremental.d1pc.f1", ""), generacion2("incremental.d1pc.f2", "");
+    string error;
+    {
+        ColaPrioritariaD1<> fila;
+        fila.agregarClientes(clientesDePrueba(50));
+        for (size_t i = 0; i < 300; ++i) registrarFactura(facturaDePrueba(i));
+        COMPROBAR(fila.guardarPuntoDeControl(archivo.ruta(), error));
+        COMPROBAR(fila.getUltimoPuntoFacturas() == 300 && fila.getUltimoPuntoFacturasNuevas() == 300);
+
+        // el segundo punto de control solo agrega las facturas cobradas desde el primero
+        for (size_t i = 300; i < 500; ++i) registrarFactura(facturaDePrueba(i));
+        COMPROBAR(fila.guardarPuntoDeControl(archivo.ruta(), error));
+        COMPROBAR(fila.getUltimoPuntoFacturas() == 500 && fila.getUltimoPuntoFacturasNuevas() == 200);
+        EstadoPuntoDeControl estado;
+        COMPROBAR(leerClientes(archivo.ruta(), estado).size() == 50);
+        COMPROBAR(mismasFacturas(estado, 500));
+    }
+
+    // otra fila sobre el mismo archivo empieza su propia generacion y la anterior se borra cuando la nueva queda escrita
+    ColaPrioritariaD1<> fila;
+    COMPROBAR(fila.guardarPuntoDeControl(archivo.ruta(), error));
+    COMPROBAR(fila.getUltimoPuntoFacturasNuevas() == 500);
+    COMPROBAR(!ifstream(generacion1.ruta()).good() && ifstream(generacion2.ruta()).good());
+    EstadoPuntoDeControl estado;
+    COMPROBAR(leerClientes(archivo.ruta(), estado).empty());
+    COMPROBAR(mismasFacturas(estado, 500));
+    if (!error.empty()) cerr << "  " << error << "\n";
+    colaFacturas.clear();
+}
+
+int main() {
+    salidaGlobal.reset(new SalidaNula());       // los carritos de prueba no anuncian cada producto
+    correr("punto de control: foto con copia al escribir", pruebaFotoConCopiaAlEscribir);
+    correr("punto de control: foto de la cola por niveles", pruebaFotoPorNiveles);
+    correr("punto de control: retomar a mitad de corrida", pruebaRetomarAMitadDeCorrida<ColaPorNiveles>);
+    correr("punto de control: retomar a mitad de corrida con heap indexado", pruebaRetomarAMitadDeCorrida<HeapIndexado>);
+    correr("punto de control: facturas incrementales", pruebaFacturasIncrementales);
+    correr("fila: envejecimiento igual en los dos almacenes", pruebaEnvejecimientoAlmacenes);
+    correr("punto de control: terminales abiertas", pruebaFotoConTerminalesAbiertas);
+    return terminarPruebas();
+}
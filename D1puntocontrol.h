@@ -0,0 +1,519 @@
+/**
+ * @file D1puntocontrol.h
+ * @author Juan Bohorquez (jbohorquezsa@unal.edu.co)
+ * @author Julian Quintero (julquinteroca@unal.edu.co)
+ * @author Santiago Herrera (sanherrerapa@unal.edu.co)
+ *
+ * @brief Formato de los puntos de control: escritura por lotes del estado de la fila y las facturas, y
+ * lectura validada para restaurarlo. La foto coherente la toma ColaPrioritariaD1
+ * @version 0.2
+ * @date 2025-10-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef D1_PUNTO_CONTROL_H
+#define D1_PUNTO_CONTROL_H
+
+#include "D1comun.h"
+
+/**
+ * @brief Formato del punto de control: cabecera "D1PC" + version (uint32), uint32 contador de llegadas, uint64 semilla de
+ * los precios, uint64 clientes, uint64 facturas, uint64 generacion del archivo de facturas, uint32 productos y el nombre
+ * de cada producto en orden de identificador (uint16 largo y bytes). Luego los registros 'C' (cliente que espera), cada
+ * uno con un byte de tipo y sin largo: uint32 orden de llegada, int64 espera en ns al tomar la foto, uint8 banderas
+ * (1 discapacidad, 2 adulto mayor, 4 embarazada), nombre y uint32 cantidad de productos con sus identificadores del fondo
+ * al tope.
+ * 
+ * Las facturas van aparte, en "ruta.f<generacion>": "D1PF" + version (uint32) y registros 'F' en orden cronologico
+ * (nombre del cliente, int64 instante, int32 total, uint32 cantidad y por cada producto uint32 id e int32 precio, con
+ * los identificadores del catalogo del punto de control). Ese archivo solo crece: cada punto de control agrega las
+ * facturas nuevas y su cabecera dice cuantas de las primeras le corresponden. La version 1 no tenia generacion y
+ * guardaba los registros 'F' en el mismo archivo; todavia se puede leer
+ * 
+ */
+inline const char MAGIA_PUNTO[4] = {'D', '1', 'P', 'C'};
+inline const char MAGIA_FACTURAS_PUNTO[4] = {'D', '1', 'P', 'F'};
+inline const uint32_t VERSION_PUNTO = 2;
+
+/**
+ * @brief Registro 'F' de una factura, igual en el archivo de facturas y en los puntos de control de la version 1
+ * 
+ * @param buffer Donde se agrega el registro
+ * @param f Factura
+ */
+inline void serializarFacturaPunto(std::vector<char>& buffer, const Factura& f) {
+    auto poner = [&](auto valor) {
+        const char* p = reinterpret_cast<const char*>(&valor);
+        buffer.insert(buffer.end(), p, p + sizeof(valor));
+    };
+    uint16_t largo = static_cast<uint16_t>(std::min<size_t>(f.nombreCliente.size(), 0xFFFF));
+    poner(uint8_t('F'));
+    poner(largo);
+    buffer.insert(buffer.end(), f.nombreCliente.data(), f.nombreCliente.data() + largo);
+    poner(int64_t(f.instanteNs));
+    poner(int32_t(f.total));
+    poner(uint32_t(f.productos.size()));
+    for (const auto& p : f.productos) {
+        poner(uint32_t(p.first));
+        poner(int32_t(p.second));
+    }
+}
+
+/**
+ * @brief Nombre del archivo de facturas de una generacion
+ * 
+ */
+inline std::string rutaFacturasPunto(const std::string& ruta, uint64_t generacion) {
+    return ruta + ".f" + std::to_string(generacion);
+}
+
+/**
+ * @brief Archivo de facturas de los puntos de control de una fila. Cada punto de control le agrega solo las facturas
+ * cobradas desde el anterior, asi guardar no vuelve a escribir todas las facturas desde el inicio. Cada fila escribe su
+ * propia generacion (la siguiente a la del punto de control que ya esta en disco) y borra la anterior cuando su primer
+ * punto de control queda escrito: un corte en cualquier momento deja un punto de control con su archivo de facturas
+ * 
+ */
+class FacturasPuntoControl {
+private:
+    FILE* archivo = nullptr;
+    std::string rutaAnterior;        // generacion que se borra cuando el primer punto de control de esta fila queda escrito
+    uint64_t generacion = 0;
+    uint64_t escritas = 0;      // facturas que ya estan en el archivo
+    std::vector<char> buffer;
+    static const size_t TAM_BLOQUE = 1 << 20;
+
+    /**
+     * @brief Generacion del punto de control que hay en 'ruta' (0 si no hay uno de la version actual)
+     * 
+     */
+    static uint64_t generacionGuardada(const std::string& ruta) {
+        FILE* f = fopen(ruta.c_str(), "rb");
+        if (!f) return 0;
+        char cabecera[44];
+        bool leida = fread(cabecera, 1, sizeof(cabecera), f) == sizeof(cabecera);
+        fclose(f);
+        uint32_t version = 0;
+        uint64_t gen = 0;
+        if (!leida || memcmp(cabecera, MAGIA_PUNTO, 4) != 0) return 0;
+        memcpy(&version, cabecera + 4, 4);
+        memcpy(&gen, cabecera + 36, 8);     // despues de version, contador, semilla, clientes y facturas
+        return version == VERSION_PUNTO ? gen : 0;
+    }
+
+public:
+    FacturasPuntoControl() = default;
+    FacturasPuntoControl(const FacturasPuntoControl&) = delete;
+    FacturasPuntoControl& operator=(const FacturasPuntoControl&) = delete;
+    ~FacturasPuntoControl() {
+        if (archivo) fclose(archivo);
+    }
+
+    /**
+     * @brief Deja el archivo listo antes de T0. La primera vez (o si las facturas en memoria ya no son las escritas)
+     * empieza una generacion nueva
+     * 
+     * @param ruta Archivo del punto de control
+     * @param enMemoria Facturas que hay ahora en memoria (solo pueden crecer hasta T0)
+     * @param error Mensaje si falla
+     * @return true Si se puede escribir
+     */
+    bool abrir(const std::string& ruta, size_t enMemoria, std::string& error) {
+        if (archivo && enMemoria >= escritas) return true;
+        if (archivo) fclose(archivo);
+        uint64_t anterior = generacionGuardada(ruta);
+        if (rutaAnterior.empty() && anterior > 0) rutaAnterior = rutaFacturasPunto(ruta, anterior);
+        generacion = anterior + 1;
+        escritas = 0;
+        buffer.clear();
+        std::string rutaNueva = rutaFacturasPunto(ruta, generacion);
+        archivo = fopen(rutaNueva.c_str(), "wb");
+        if (!archivo) {
+            error = "No se pudo crear " + rutaNueva;
+            return false;
+        }
+        setvbuf(archivo, nullptr, _IONBF, 0);
+        buffer.insert(buffer.end(), MAGIA_FACTURAS_PUNTO, MAGIA_FACTURAS_PUNTO + 4);
+        const char* version = reinterpret_cast<const char*>(&VERSION_PUNTO);
+        buffer.insert(buffer.end(), version, version + 4);
+        return true;
+    }
+
+    /**
+     * @brief Agrega una factura nueva (la siguiente a las ya escritas)
+     * 
+     */
+    void agregar(const Factura& f) {
+        serializarFacturaPunto(buffer, f);
+        ++escritas;
+        if (buffer.size() >= TAM_BLOQUE) {
+            if (fwrite(buffer.data(), 1, buffer.size(), archivo) != buffer.size()) buffer.push_back(0);       // lo detecta vaciar
+            else buffer.clear();
+        }
+    }
+
+    /**
+     * @brief Escribe lo pendiente. Se llama antes de reemplazar el punto de control. Si falla, el siguiente punto de
+     * control empieza otra vez esta generacion desde cero
+     * 
+     * @param error Mensaje si falla
+     * @return true Si las facturas quedaron en el archivo
+     */
+    bool vaciar(std::string& error) {
+        bool bien = fwrite(buffer.data(), 1, buffer.size(), archivo) == buffer.size() && fflush(archivo) == 0;
+        buffer.clear();
+        if (!bien) {
+            fclose(archivo);
+            archivo = nullptr;
+            error = "No se pudieron escribir las facturas del punto de control";
+        }
+        return bien;
+    }
+
+    /**
+     * @brief El punto de control que apunta a esta generacion ya reemplazo al anterior: la generacion vieja sobra
+     * 
+     */
+    void confirmar() {
+        if (rutaAnterior.empty()) return;
+        remove(rutaAnterior.c_str());
+        rutaAnterior.clear();
+    }
+
+    uint64_t getGeneracion() const { return generacion; }
+    uint64_t getEscritas() const { return escritas; }
+};
+
+/**
+ * @brief Lo que se recupera de un punto de control
+ * 
+ */
+struct EstadoPuntoDeControl {
+    uint32_t contadorLlegadas = 0;      // proximo orden de llegada: el orden FIFO sigue donde iba
+    uint64_t semilla = 0;               // semilla de los precios de la corrida guardada
+    std::vector<Cliente> clientes;           // su llegadaNs ya esta sobre el reloj actual (ahora - espera)
+    std::vector<Factura> facturas;           // en orden cronologico
+};
+
+/**
+ * @brief Punto de control de la fila y las facturas en memoria. La foto se toma en un instante (T0) pero se copia despues,
+ * mientras las cajas siguen cobrando: lo que no puede esperar (cabecera, lotes de las cajas) se escribe en T0 y los
+ * clientes de la fila se copian por trozos o, si una caja va a sacar o cambiar a uno que aun no se copio, justo antes
+ * (copia al escribir). Se escribe a "ruta.tmp" y se renombra al terminar, asi un corte a mitad deja el punto anterior
+ * 
+ */
+class PuntoDeControl {
+private:
+    FILE* archivo = nullptr;
+    std::string rutaTemporal;
+    std::vector<char> buffer;        // registros pendientes de escribir
+    std::mutex m;        // el hilo del punto de control y las cajas (copia al escribir) agregan registros a la vez
+    int64_t instanteNs = 0;     // T0 en el reloj monotono: las esperas se guardan relativas a el
+    uint64_t clientesEsperados = 0;     // lo que habia en T0
+    uint64_t clientes = 0;      // lo que ya se copio
+    static const size_t TAM_BLOQUE = 1 << 20;       // se escribe al archivo cada 1 MiB
+
+    template <class T>
+    void poner(T valor) {       // agrega un entero al buffer
+        const char* p = reinterpret_cast<const char*>(&valor);
+        buffer.insert(buffer.end(), p, p + sizeof(T));
+    }
+
+    void ponerTexto(std::string_view texto) {        // largo (uint16) y bytes
+        uint16_t largo = static_cast<uint16_t>(std::min<size_t>(texto.size(), 0xFFFF));
+        poner(largo);
+        buffer.insert(buffer.end(), texto.data(), texto.data() + largo);
+    }
+
+public:
+    PuntoDeControl() = default;
+    PuntoDeControl(const PuntoDeControl&) = delete;
+    PuntoDeControl& operator=(const PuntoDeControl&) = delete;
+
+    ~PuntoDeControl() {     // si no se llego a cerrar, el archivo temporal no sirve
+        if (archivo) {
+            fclose(archivo);
+            remove(rutaTemporal.c_str());
+        }
+    }
+
+    /**
+     * @brief Crea el archivo temporal. Se llama antes de T0 para no abrir archivos con la fila bloqueada
+     * 
+     * @param ruta Archivo final del punto de control
+     * @param error Mensaje si falla
+     * @return true Si se pudo crear
+     */
+    bool abrir(const std::string& ruta, std::string& error) {
+        rutaTemporal = ruta + ".tmp";
+        archivo = fopen(rutaTemporal.c_str(), "wb");
+        if (!archivo) {
+            error = "No se pudo crear " + rutaTemporal;
+            return false;
+        }
+        setvbuf(archivo, nullptr, _IONBF, 0);       // el buffer propio ya agrupa las escrituras
+        buffer.reserve(TAM_BLOQUE + 4096);
+        return true;
+    }
+
+    /**
+     * @brief Escribe la cabecera y el catalogo. Se llama en T0, con la fila y las facturas bloqueadas
+     * 
+     * @param contadorLlegadas Proximo orden de llegada
+     * @param semilla Semilla de los precios, para cobrar igual a los clientes restaurados
+     * @param numClientes Clientes que esperan en T0 (fila y lotes de las cajas)
+     * @param numFacturas Facturas guardadas en memoria en T0 (las primeras del archivo de facturas)
+     * @param generacion Generacion del archivo de facturas (FacturasPuntoControl)
+     */
+    void cabecera(uint32_t contadorLlegadas, uint64_t semilla, uint64_t numClientes, uint64_t numFacturas, uint64_t generacion) {
+        std::lock_guard<std::mutex> lock(m);
+        instanteNs = ahoraNs();
+        clientesEsperados = numClientes;
+        buffer.insert(buffer.end(), MAGIA_PUNTO, MAGIA_PUNTO + 4);
+        poner(VERSION_PUNTO);
+        poner(contadorLlegadas);
+        poner(semilla);
+        poner(numClientes);
+        poner(numFacturas);
+        poner(generacion);
+        uint32_t productos = static_cast<uint32_t>(catalogo().size());
+        poner(productos);
+        for (uint32_t id = 0; id < productos; ++id) ponerTexto(catalogo().nombre(id));
+    }
+
+    /**
+     * @brief Copia un cliente tal como estaba en T0
+     * 
+     * @param c Cliente que seguia esperando en T0
+     */
+    void agregarCliente(const Cliente& c) {
+        std::lock_guard<std::mutex> lock(m);
+        poner(uint8_t('C'));
+        poner(uint32_t(c.ordenLlegada));
+        poner(int64_t(instanteNs - c.llegadaNs));
+        poner(uint8_t((c.discapacidad ? 1 : 0) | (c.adultoMayor ? 2 : 0) | (c.embarazada ? 4 : 0)));
+        ponerTexto(c.nombre);
+        VistaProductos productos = c.carrito.verProductos();
+        poner(uint32_t(productos.size()));
+        for (IdProducto id : productos) poner(uint32_t(id));
+        ++clientes;
+    }
+
+    /**
+     * @brief Escribe al archivo lo acumulado si ya hay un bloque completo. No bloquea a las cajas mientras escribe
+     * 
+     * @param todo Escribir aunque no se haya llenado el bloque
+     */
+    void vaciar(bool todo = false) {
+        std::vector<char> listo;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            if (buffer.empty() || (!todo && buffer.size() < TAM_BLOQUE)) return;
+            listo.swap(buffer);
+            buffer.reserve(TAM_BLOQUE + 4096);
+        }
+        fwrite(listo.data(), 1, listo.size(), archivo);
+    }
+
+    /**
+     * @brief Termina el punto de control: escribe lo pendiente y reemplaza el archivo anterior
+     * 
+     * @param ruta Archivo final
+     * @param error Mensaje si falla
+     * @return true Si el punto de control quedo completo
+     */
+    bool cerrar(const std::string& ruta, std::string& error) {
+        vaciar(true);
+        bool completo = clientes == clientesEsperados;
+        bool escrito = fflush(archivo) == 0 && !ferror(archivo);
+        fclose(archivo);
+        archivo = nullptr;
+        if (!completo || !escrito) {
+            remove(rutaTemporal.c_str());
+            error = completo ? "No se pudo escribir " + rutaTemporal : "El punto de control quedó incompleto";
+            return false;
+        }
+#ifdef _WIN32
+        remove(ruta.c_str());       // en Windows rename no reemplaza un archivo existente
+#endif
+        if (rename(rutaTemporal.c_str(), ruta.c_str()) != 0) {
+            remove(rutaTemporal.c_str());
+            error = "No se pudo reemplazar " + ruta;
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t clientesCopiados() const { return clientes; }
+
+    /**
+     * @brief Lee un punto de control completo. Los productos se vuelven a registrar en el catalogo (los identificadores
+     * pueden cambiar entre corridas) y la llegada de cada cliente se corre al reloj actual conservando su espera. Las
+     * facturas salen de las primeras registradas en su archivo de facturas; lo que haya despues es de un punto de control
+     * posterior que no llego a escribirse
+     * 
+     * @param ruta Archivo del punto de control
+     * @param estado Donde se deja lo leido
+     * @param error Mensaje si el archivo no sirve
+     * @return true Si se leyo completo
+     */
+    static bool leer(const std::string& ruta, EstadoPuntoDeControl& estado, std::string& error) {
+        ArchivoMapeado mapa;
+        if (!mapa.abrir(ruta, error)) return false;
+        const char* p = mapa.data();
+        const char* fin = p + mapa.size();
+        bool completo = true;
+        auto tomar = [&](auto& valor) {     // entero sin alineacion; si no alcanza el archivo queda marcado como dañado
+            if (static_cast<size_t>(fin - p) < sizeof(valor)) {
+                completo = false;
+                return;
+            }
+            memcpy(&valor, p, sizeof(valor));
+            p += sizeof(valor);
+        };
+        auto tomarTexto = [&]() {
+            uint16_t largo = 0;
+            tomar(largo);
+            if (static_cast<size_t>(fin - p) < largo) {
+                completo = false;
+                return std::string_view();
+            }
+            std::string_view texto(p, largo);
+            p += largo;
+            return texto;
+        };
+
+        if (mapa.size() < 8 || memcmp(p, MAGIA_PUNTO, 4) != 0) {
+            error = ruta + " no es un punto de control";
+            return false;
+        }
+        p += 4;
+        uint32_t version = 0, productos = 0;
+        uint64_t numClientes = 0, numFacturas = 0;
+        tomar(version);
+        if (version != VERSION_PUNTO && version != 1) {
+            error = ruta + ": versión de punto de control no soportada (" + std::to_string(version) + ")";
+            return false;
+        }
+        tomar(estado.contadorLlegadas);
+        tomar(estado.semilla);
+        tomar(numClientes);
+        tomar(numFacturas);
+        uint64_t generacion = 0;
+        if (version != 1) tomar(generacion);
+        tomar(productos);
+        std::vector<IdProducto> ids;     // identificador guardado -> identificador en el catalogo de esta corrida
+        ids.reserve(std::min<size_t>(productos, mapa.size() / 2));
+        for (uint32_t i = 0; i < productos && completo; ++i) ids.push_back(catalogo().registrar(tomarTexto()));
+
+        auto leerFactura = [&]() {      // registro 'F' sin el tipo; false si el producto no existe
+            int64_t instante = 0;
+            int32_t total = 0;
+            uint32_t cantidad = 0;
+            std::string_view nombre = tomarTexto();
+            tomar(instante);
+            tomar(total);
+            tomar(cantidad);
+            if (!completo || static_cast<size_t>(fin - p) / 8 < cantidad) {
+                completo = false;
+                return true;
+            }
+            ProductosFactura prods(recursoActual());
+            prods.reserve(cantidad);
+            for (uint32_t i = 0; i < cantidad; ++i, p += 8) {
+                uint32_t id;
+                int32_t precio;
+                memcpy(&id, p, 4);
+                memcpy(&precio, p + 4, 4);
+                if (id >= ids.size()) {
+                    error = "Producto desconocido en el punto de control";
+                    return false;
+                }
+                prods.emplace_back(ids[id], precio);
+            }
+            estado.facturas.emplace_back(nombre, std::move(prods), total, instante);
+            return true;
+        };
+
+        size_t maximo = mapa.size() / 16;       // un registro ocupa al menos 16 bytes: acota la reserva si la cabecera esta dañada
+        estado.clientes.reserve(std::min<size_t>(numClientes, maximo));
+        if (version == 1) estado.facturas.reserve(std::min<size_t>(numFacturas, maximo));
+        int64_t ahora = ahoraNs();
+        while (completo && p < fin) {
+            uint8_t tipo = 0;
+            uint32_t cantidad = 0;
+            tomar(tipo);
+            if (tipo == 'C') {
+                uint32_t orden = 0;
+                int64_t espera = 0;
+                uint8_t banderas = 0;
+                tomar(orden);
+                tomar(espera);
+                tomar(banderas);
+                std::string_view nombre = tomarTexto();
+                tomar(cantidad);
+                if (!completo || static_cast<size_t>(fin - p) / 4 < cantidad) break;
+                PilaProductos pila;
+                pila.reservar(cantidad);
+                for (uint32_t i = 0; i < cantidad; ++i, p += 4) {
+                    uint32_t id;
+                    memcpy(&id, p, 4);
+                    if (id >= ids.size()) {
+                        error = "Producto desconocido en el punto de control";
+                        return false;
+                    }
+                    pila.push(ids[id]);
+                }
+                estado.clientes.emplace_back(nombre, CarritoDeCompras(nombre, std::move(pila)),
+                                             (banderas & 1) != 0, (banderas & 2) != 0, (banderas & 4) != 0, static_cast<int>(orden));
+                estado.clientes.back().llegadaNs = ahora - espera;
+            } else if (tipo == 'F' && version == 1) {
+                if (!leerFactura()) return false;
+            } else {
+                error = "Tipo de registro desconocido en el punto de control: " + std::to_string(tipo);
+                return false;
+            }
+        }
+        if (!completo || p != fin || estado.clientes.size() != numClientes) {
+            error = ruta + ": punto de control dañado o incompleto";
+            return false;
+        }
+
+        ArchivoMapeado mapaFacturas;
+        if (version != 1 && numFacturas > 0) {
+            std::string rutaFacturas = rutaFacturasPunto(ruta, generacion);
+            if (!mapaFacturas.abrir(rutaFacturas, error)) return false;
+            p = mapaFacturas.data();
+            fin = p + mapaFacturas.size();
+            uint32_t versionFacturas = 0;
+            if (mapaFacturas.size() < 8 || memcmp(p, MAGIA_FACTURAS_PUNTO, 4) != 0) {
+                error = rutaFacturas + " no es un archivo de facturas";
+                return false;
+            }
+            p += 4;
+            tomar(versionFacturas);
+            if (versionFacturas != VERSION_PUNTO) {
+                error = rutaFacturas + ": versión no soportada (" + std::to_string(versionFacturas) + ")";
+                return false;
+            }
+            estado.facturas.reserve(std::min<size_t>(numFacturas, mapaFacturas.size() / 16));
+            for (uint64_t i = 0; i < numFacturas && completo; ++i) {
+                uint8_t tipo = 0;
+                tomar(tipo);
+                if (completo && tipo != 'F') {
+                    error = "Tipo de registro desconocido en " + rutaFacturas + ": " + std::to_string(tipo);
+                    return false;
+                }
+                if (completo && !leerFactura()) return false;
+            }
+        }
+        if (!completo || estado.facturas.size() != numFacturas) {
+            error = ruta + ": punto de control dañado o incompleto";
+            return false;
+        }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,191 @@
+/**
+ * @file D1traza.h
+ * @author Juan Bohorquez (jbohorquezsa@unal.edu.co)
+ * @author Julian Quintero (julquinteroca@unal.edu.co)
+ * @author Santiago Herrera (sanherrerapa@unal.edu.co)
+ *
+ * @brief Lectura en paralelo de las trazas de llegadas (--traza)
+ * @version 0.2
+ * @date 2025-10-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef D1_TRAZA_H
+#define D1_TRAZA_H
+
+#include <thread>    // Un hilo lector por trozo del archivo
+#include <limits>    // Limite de productos por traza
+
+#include "D1comun.h"
+
+/**
+ * @brief Traza de llegadas, un cliente por linea: "nombre;prioridad;productos;llegada". La prioridad usa las opciones de
+ * askPriorityFlags (1 discapacidad, 2 adulto mayor, 3 embarazada, 4 ninguna), los productos van separados por '|' y la
+ * llegada (microsegundos, opcional) ordena a los clientes; sin ella el cliente llega junto con el anterior.
+ * El archivo se mapea en memoria y se reparte en trozos que se leen en paralelo. Los registros apuntan al archivo
+ * (string_view): el nombre y el carrito se copian solo cuando el cliente entra a la fila
+ * 
+ */
+class TrazaLlegadas {
+private:
+    struct Registro {
+        std::string_view nombre;         // dentro del archivo mapeado
+        int64_t llegada;            // -1 si la linea no la trae
+        uint32_t primerProducto;    // posicion en productos
+        uint32_t cantidad;
+        char opcion;                // 1-4 como en askPriorityFlags
+    };
+
+    struct Trozo {      // resultado de un hilo lector
+        std::vector<Registro> registros;
+        std::vector<IdProducto> productos;
+        const char* posError = nullptr;     // inicio de la primera linea con error
+        std::string error;
+    };
+
+    ArchivoMapeado archivo;
+    std::vector<Registro> registros;
+    std::vector<IdProducto> productos;       // carritos de todos los clientes, uno tras otro
+
+    /**
+     * @brief Lee las lineas completas de un trozo de la traza
+     * 
+     * @param texto Trozo que empieza y termina en un limite de linea
+     * @param trozo Resultado del trozo
+     */
+    static void leerTrozo(std::string_view texto, Trozo& trozo) {
+        std::unordered_map<std::string_view, IdProducto> vistos;      // cache del hilo: evita el candado del catalogo en productos repetidos
+        auto fallar = [&](const char* linea, const std::string& mensaje) {
+            trozo.posError = linea;
+            trozo.error = mensaje;
+        };
+        trozo.registros.reserve(static_cast<size_t>(std::count(texto.begin(), texto.end(), '\n')) + 1);
+
+        while (!texto.empty()) {
+            size_t fin = texto.find('\n');
+            std::string_view linea = texto.substr(0, fin);
+            texto.remove_prefix(fin == std::string_view::npos ? texto.size() : fin + 1);
+            if (!linea.empty() && linea.back() == '\r') linea.remove_suffix(1);       // archivos guardados en Windows
+            if (linea.empty() || linea[0] == '#') continue;     // lineas vacias y comentarios
+
+            std::string_view campos[5];      // el quinto solo indica que sobran campos
+            size_t cantidad = 0;
+            for (std::string_view resto = linea; cantidad < 5; ) {
+                size_t sep = resto.find(';');
+                campos[cantidad++] = resto.substr(0, sep);
+                if (sep == std::string_view::npos) break;
+                resto.remove_prefix(sep + 1);
+            }
+            if (cantidad < 3 || cantidad > 4) return fallar(linea.data(), "se esperaba nombre;prioridad;productos[;llegada]");
+            if (campos[0].empty()) return fallar(linea.data(), "el nombre no puede estar vacío");
+            if (campos[1].size() != 1 || campos[1][0] < '1' || campos[1][0] > '4')
+                return fallar(linea.data(), "la prioridad debe ser 1, 2, 3 o 4");
+
+            Registro r{campos[0], -1, static_cast<uint32_t>(trozo.productos.size()), 0, campos[1][0]};
+            if (cantidad == 4 && !campos[3].empty()) {
+                const char* finCampo = campos[3].data() + campos[3].size();
+                auto leido = std::from_chars(campos[3].data(), finCampo, r.llegada);
+                if (leido.ec != std::errc() || leido.ptr != finCampo || r.llegada < 0)
+                    return fallar(linea.data(), "instante de llegada inválido");
+            }
+
+            for (std::string_view resto = campos[2]; !resto.empty(); ) {
+                size_t sep = resto.find('|');
+                std::string_view producto = resto.substr(0, sep);
+                resto.remove_prefix(sep == std::string_view::npos ? resto.size() : sep + 1);
+                if (producto.empty()) continue;
+                auto it = vistos.find(producto);
+                if (it == vistos.end()) it = vistos.emplace(producto, catalogo().registrar(producto)).first;
+                trozo.productos.push_back(it->second);
+                ++r.cantidad;
+            }
+            trozo.registros.push_back(r);
+        }
+    }
+
+public:
+    /**
+     * @brief Mapea y lee una traza completa
+     * 
+     * @param ruta Archivo de la traza
+     * @param error Mensaje si falla (con el numero de linea)
+     * @param hilosLectores Hilos lectores; 0 = uno por nucleo con trozos de al menos 1 MiB (las pruebas fijan otro valor
+     * para partir archivos pequeños)
+     * @return true Si se pudo leer toda la traza
+     */
+    bool cargar(const std::string& ruta, std::string& error, size_t hilosLectores = 0) {
+        registros.clear();
+        productos.clear();
+        if (!archivo.abrir(ruta, error)) return false;
+        std::string_view texto(archivo.data(), archivo.size());
+
+        size_t hilos = hilosLectores;
+        if (hilos == 0) {
+            hilos = std::max<size_t>(1, std::thread::hardware_concurrency());
+            hilos = std::min(hilos, std::max<size_t>(1, texto.size() >> 20));       // trozos de al menos 1 MiB
+        }
+        std::vector<Trozo> trozos(hilos);
+        std::vector<std::thread> lectores;
+        size_t inicio = 0;
+        for (size_t k = 0; k < hilos; ++k) {
+            size_t fin = (k + 1 == hilos) ? texto.size() : std::max(inicio, texto.size() * (k + 1) / hilos);
+            while (fin > 0 && fin < texto.size() && texto[fin - 1] != '\n') ++fin;       // cada trozo termina en un salto de linea
+            std::string_view parte = texto.substr(inicio, fin - inicio);
+            lectores.emplace_back([parte, &trozo = trozos[k]]() { leerTrozo(parte, trozo); });
+            inicio = fin;
+        }
+        for (std::thread& h : lectores) h.join();
+
+        size_t totalRegistros = 0, totalProductos = 0;
+        for (const Trozo& t : trozos) {
+            if (t.posError != nullptr) {        // los trozos estan en orden: el primero con error es el primero del archivo
+                size_t linea = 1 + static_cast<size_t>(std::count(archivo.data(), t.posError, '\n'));
+                error = ruta + ":" + std::to_string(linea) + ": " + t.error;
+                return false;
+            }
+            totalRegistros += t.registros.size();
+            totalProductos += t.productos.size();
+        }
+        if (totalProductos > std::numeric_limits<uint32_t>::max()) {
+            error = ruta + ": la traza tiene demasiados productos";
+            return false;
+        }
+
+        registros.reserve(totalRegistros);
+        productos.reserve(totalProductos);
+        int64_t anterior = 0;
+        for (Trozo& t : trozos) {
+            uint32_t desplazamiento = static_cast<uint32_t>(productos.size());
+            productos.insert(productos.end(), t.productos.begin(), t.productos.end());
+            for (Registro r : t.registros) {
+                r.primerProducto += desplazamiento;
+                r.llegada = (r.llegada < 0) ? anterior : (anterior = r.llegada);
+                registros.push_back(r);
+            }
+        }
+        auto porLlegada = [](const Registro& a, const Registro& b) { return a.llegada < b.llegada; };
+        if (!is_sorted(registros.begin(), registros.end(), porLlegada))       // traza desordenada: los empates conservan el orden del archivo
+            std::stable_sort(registros.begin(), registros.end(), porLlegada);
+        return true;
+    }
+
+    size_t size() const { return registros.size(); }        // cantidad de clientes
+    int64_t llegadaUs(size_t i) const { return registros[i].llegada; }      // instante de llegada del i-esimo cliente
+
+    /**
+     * @brief Arma el i-esimo cliente en orden de llegada (se puede llamar desde varias terminales a la vez)
+     * 
+     * @param i Posicion en la traza ordenada
+     * @return Cliente Cliente con su carrito (el orden de llegada lo asigna la fila)
+     */
+    Cliente cliente(size_t i) const {
+        const Registro& r = registros[i];
+        PilaProductos carrito;
+        for (uint32_t p = 0; p < r.cantidad; ++p) carrito.push(productos[r.primerProducto + p]);
+        CarritoDeCompras c(r.nombre, std::move(carrito));
+        return Cliente(r.nombre, std::move(c), r.opcion == '1', r.opcion == '2', r.opcion == '3', 0);
+    }
+};
+
+#endif